@@ -0,0 +1,177 @@
+#include "dispatch.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <cpuid.h>
+
+#include "variants.h"
+
+// Entry points of the variants, see variant.h.
+#define X(Namespace, Name, Isa, Magic)                                                  \
+    namespace Namespace::Variant {                                                      \
+    void uci(const std::string &name, const std::string &author);                       \
+    }
+FKTB_ISA_VARIANTS(X)
+#undef X
+
+namespace FKTB {
+
+namespace {
+
+struct VariantEntry {
+    const char *name;
+    const char *isa;
+    bool magic;
+    void (*uci)(const std::string &name, const std::string &author);
+};
+
+// @formatter:off
+#define X(Namespace, Name, Isa, Magic) { Name, Isa, Magic, Namespace::Variant::uci },
+constexpr VariantEntry Variants[] = { FKTB_ISA_VARIANTS(X) };
+#undef X
+// @formatter:on
+
+const VariantEntry *selectedVariant = nullptr;
+
+
+// CPU feature detection
+struct CpuFeatures {
+    bool v2 = false;
+    bool v3 = false;
+    bool v4 = false;
+
+    // PEXT and PDEP are microcoded on AMD CPUs before Zen 3, and are much slower than magic bitboards.
+    bool slowPext = false;
+};
+
+struct CpuidRegisters {
+    uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+};
+
+CpuidRegisters cpuid(uint32_t leaf, uint32_t subleaf = 0) {
+    CpuidRegisters registers;
+    if (__get_cpuid_max(leaf & 0x80000000, nullptr) >= leaf) {
+        __cpuid_count(leaf, subleaf, registers.eax, registers.ebx, registers.ecx, registers.edx);
+    }
+    return registers;
+}
+
+uint64_t xgetbv() {
+    uint32_t eax, edx;
+    __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+}
+
+constexpr bool hasBits(uint32_t value, uint32_t bits) {
+    return (value & bits) == bits;
+}
+
+// Feature bits of the microarchitecture levels, as defined by the x86-64 psABI.
+CpuFeatures detectCpuFeatures() {
+    CpuFeatures features;
+
+    CpuidRegisters leaf1 = cpuid(1);
+    CpuidRegisters leaf7 = cpuid(7);
+    CpuidRegisters extendedLeaf1 = cpuid(0x80000001);
+
+    // SSE3, SSSE3, CMPXCHG16B, SSE4.1, SSE4.2, POPCNT, and LAHF/SAHF.
+    features.v2 = hasBits(leaf1.ecx, (1 << 0) | (1 << 9) | (1 << 13) | (1 << 19) | (1 << 20) | (1 << 23)) &&
+                  hasBits(extendedLeaf1.ecx, 1 << 0);
+
+    // The OS must have enabled saving of the AVX registers (OSXSAVE) for AVX to be usable.
+    bool osxsave = hasBits(leaf1.ecx, 1 << 27);
+    uint64_t xcr0 = osxsave ? xgetbv() : 0;
+
+    // AVX, AVX2, BMI1, BMI2, F16C, FMA, LZCNT, and MOVBE, and the OS saves the XMM and YMM registers.
+    features.v3 = features.v2 && osxsave && (xcr0 & 0x6) == 0x6 &&
+                  hasBits(leaf1.ecx, (1 << 12) | (1 << 22) | (1 << 28) | (1 << 29)) &&
+                  hasBits(leaf7.ebx, (1 << 3) | (1 << 5) | (1 << 8)) &&
+                  hasBits(extendedLeaf1.ecx, 1 << 5);
+
+    // AVX512F, AVX512BW, AVX512CD, AVX512DQ, and AVX512VL, and the OS saves the opmask and ZMM registers.
+    features.v4 = features.v3 && (xcr0 & 0xE0) == 0xE0 &&
+                  hasBits(leaf7.ebx, (1U << 16) | (1U << 17) | (1U << 28) | (1U << 30) | (1U << 31));
+
+    // Zen 1 and Zen 2 are family 17h.
+    CpuidRegisters leaf0 = cpuid(0);
+    bool amd = (leaf0.ebx == 0x68747541 && leaf0.edx == 0x69746E65 && leaf0.ecx == 0x444D4163); // "AuthenticAMD"
+    uint32_t family = ((leaf1.eax >> 8) & 0xF) + ((leaf1.eax >> 20) & 0xFF);
+    features.slowPext = amd && family == 0x17;
+
+    return features;
+}
+
+// Returns the number of an instruction set level, or -1 if it is not a known level.
+int32_t variantLevel(const char *isa) {
+    if (std::strcmp(isa, "x86-64") == 0) {
+        return 1;
+    } else if (std::strcmp(isa, "x86-64-v2") == 0) {
+        return 2;
+    } else if (std::strcmp(isa, "x86-64-v3") == 0) {
+        return 3;
+    } else if (std::strcmp(isa, "x86-64-v4") == 0) {
+        return 4;
+    } else {
+        return -1;
+    }
+}
+
+bool isSupported(const CpuFeatures &features, int32_t level) {
+    // @formatter:off
+    switch (level) {
+        case 1:  return true;
+        case 2:  return features.v2;
+        case 3:  return features.v3;
+        case 4:  return features.v4;
+        default: return false;
+    }
+    // @formatter:on
+}
+
+} // namespace
+
+
+
+void init() {
+    CpuFeatures features = detectCpuFeatures();
+
+    // Variants are ordered from the lowest level to the highest, so the last supported variant is the best one. Variants from
+    // x86-64-v3 up use PEXT bitboards unless they were compiled with magic bitboards. Of two variants for the same level, the PEXT
+    // one is preferred, unless the CPU has slow PEXT, in which case PEXT variants are only used if there is nothing else.
+    int32_t selectedLevel = 0;
+    for (const VariantEntry &variant : Variants) {
+        int32_t level = variantLevel(variant.isa);
+        if (!isSupported(features, level)) {
+            continue;
+        }
+
+        bool usesPext = level >= 3 && !variant.magic;
+        if (selectedVariant != nullptr && (features.slowPext ? usesPext : (level == selectedLevel && !usesPext))) {
+            continue;
+        }
+
+        selectedVariant = &variant;
+        selectedLevel = level;
+    }
+
+    if (selectedVariant == nullptr) {
+        std::cerr << "This CPU does not support any of the instruction sets that FKTB was compiled for." << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+const char *variantName() {
+    assert(selectedVariant != nullptr && "FKTB::init() must be called first.");
+    return selectedVariant->name;
+}
+
+void uci(const std::string &name, const std::string &author) {
+    assert(selectedVariant != nullptr && "FKTB::init() must be called first.");
+    selectedVariant->uci(name, author);
+}
+
+} // namespace FKTB
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+namespace FKTB {
+
+// Selects the engine variant for the highest instruction set level that the CPU supports. Must be called before anything else.
+void init();
+
+// Returns the name of the selected variant's instruction set level (e.g. "x86-64-v3").
+[[nodiscard]] const char *variantName();
+
+// Runs the UCI loop of the selected variant until the GUI quits.
+void uci(const std::string &name, const std::string &author);
+
+} // namespace FKTB
@@ -7,6 +7,7 @@
 #include "square.h"
 #include "piece.h"
 #include "board.h"
+#include "slider_tables.h"
 #include "engine/inline.h"
 #include "engine/intrinsics.h"
 
@@ -34,48 +35,22 @@ std::string Bitboard::debug() const {
 
 namespace {
 
-// Table of bitboards with all the squares between two squares.
-// See https://www.chessprogramming.org/Square_Attacked_By#0x88_Difference
-std::array<Bitboard, 240> between0x88Table;
-
-// Using PEXT bitboards for generating sliding piece attacks: https://www.chessprogramming.org/BMI2#PEXTBitboards
-// (similar to magic bitboards, but without the magic :) )
-struct PextTableEntry {
-    Bitboard occupiedMask;  // The mask of occupied squares.
-    Bitboard attackMask;    // Attacks on an empty board.
-    uint32_t offset;        // The offset into the attack table.
-
-    PextTableEntry() : occupiedMask(0), attackMask(0), offset(0) { }
-    PextTableEntry(Bitboard occupiedMask, Bitboard attackMask, uint32_t offset) : occupiedMask(occupiedMask),
-                                                                                  attackMask(attackMask),
-                                                                                  offset(offset) { }
-};
-
-// Total 213.25 KiB
-SquareMap<PextTableEntry> diagonalPextTable;        // 1.5 KiB
-SquareMap<PextTableEntry> orthogonalPextTable;      // 1.5 KiB
-std::array<uint16_t, 107648> slidingAttackTable;    // 210.25 KiB
-
-ColorMap<SquareMap<Bitboard>> pawnAttackTable;
-SquareMap<Bitboard> knightAttackTable;
-SquareMap<Bitboard> kingAttackTable;
-
-
+// All the tables are generated at compile time (or at build time for the slider attack tables, see slider_tables.h), so that they
+// live in read-only memory (which is shared between processes) and no work needs to be done at startup.
 
 // No clue what this does but see https://www.chessprogramming.org/Square_Attacked_By#0x88_Difference
-INLINE uint8_t x88Diff(Square from, Square to) {
+INLINE constexpr uint8_t x88Diff(Square from, Square to) {
     return to - from + (to | 7) - (from | 7) + 120;
 }
 
-// This is an expensive method, only call during initialization.
-Bitboard generateBetween(Square a, Square b) {
+constexpr Bitboard generateBetween(Square a, Square b) {
     // Copied from https://www.chessprogramming.org/Square_Attacked_By#Pure_Calculation
     // @formatter:off
     constexpr uint64_t m1   = -1ULL;
     constexpr uint64_t a2a7 = 0x0001010101010100ULL;
     constexpr uint64_t b2g7 = 0x0040201008040200ULL;
     constexpr uint64_t h1b7 = 0x0002040810204080ULL; /* Thanks Dustin, g2b7 did not work for c1-a3 */
-    uint64_t btwn, line, rank, file;
+    uint64_t btwn = 0, line = 0, rank = 0, file = 0;
 
     btwn  = (m1 << a) ^ (m1 << b);
     file  =   (b & 7) - (a   & 7);
@@ -89,7 +64,8 @@ Bitboard generateBetween(Square a, Square b) {
     // @formatter:on
 }
 
-void initBetweenTable() {
+constexpr std::array<Bitboard, 240> generateBetweenTable() {
+    std::array<Bitboard, 240> table = { };
     for (uint8_t a = 0; a < 64; ++a) {
         for (uint8_t b = 0; b < 64; ++b) {
             if (a == b) {
@@ -98,156 +74,20 @@ void initBetweenTable() {
 
             uint8_t index = x88Diff(a, b);
             Bitboard between = generateBetween(a, b);
-            between0x88Table[index] = Intrinsics::ror(between, a);
+            table[index] = Intrinsics::ror(between, a);
         }
     }
+    return table;
 }
 
+// Table of bitboards with all the squares between two squares.
+// See https://www.chessprogramming.org/Square_Attacked_By#0x88_Difference
+constexpr std::array<Bitboard, 240> Between0x88Table = generateBetweenTable();
 
 
-// This is an expensive method, only call during initialization.
-Bitboard generateRayAttacks(Square square, int8_t fileDelta, int8_t rankDelta, Bitboard blockers) {
-    Bitboard attacks;
-
-    int32_t file = Square::file(square) + fileDelta;
-    int32_t rank = Square::rank(square) + rankDelta;
-
-    while (file >= 0 && file <= 7 && rank >= 0 && rank <= 7) {
-        Square attack(file, rank);
-
-        attacks.set(attack);
-
-        if (blockers.get(attack)) {
-            break;
-        }
-
-        file += fileDelta;
-        rank += rankDelta;
-    }
-
-    return attacks;
-}
-
-void initDiagonalAttacks(uint32_t &attackOffset) {
-    for (uint8_t square = 0; square < 64; ++square) {
-        // Generate the occupied mask for the square.
-        Bitboard occupiedMask;
-        {
-            // Don't need to go all the way to the edge of the board since those squares will not affect the attacks
-            // regardless of if they are occupied or not.
-            int32_t file = Square::file(square) - 1;
-            int32_t rank = Square::rank(square) - 1;
-            while (file >= 1 && rank >= 1) {
-                occupiedMask.set(Square(file--, rank--));
-            }
-
-            file = Square::file(square) + 1;
-            rank = Square::rank(square) - 1;
-            while (file < 7 && rank >= 1) {
-                occupiedMask.set(Square(file++, rank--));
-            }
-
-            file = Square::file(square) - 1;
-            rank = Square::rank(square) + 1;
-            while (file >= 1 && rank < 7) {
-                occupiedMask.set(Square(file--, rank++));
-            }
-
-            file = Square::file(square) + 1;
-            rank = Square::rank(square) + 1;
-            while (file < 7 && rank < 7) {
-                occupiedMask.set(Square(file++, rank++));
-            }
-        }
-
-        // Generate the attack mask for the square.
-        Bitboard attackMask;
-        attackMask |= generateRayAttacks(square, 1, 1, 0);
-        attackMask |= generateRayAttacks(square, -1, 1, 0);
-        attackMask |= generateRayAttacks(square, 1, -1, 0);
-        attackMask |= generateRayAttacks(square, -1, -1, 0);
-
-        // Generate all attacks for the square.
-        assert(occupiedMask.count() <= 16 && "Too many occupied squares.");
-        uint16_t attackCount = (1 << occupiedMask.count());
-
-        for (uint16_t index = 0; index < attackCount; ++index) {
-            Bitboard blockers = Intrinsics::pdep(index, occupiedMask);
-
-            Bitboard attacks;
-
-            attacks |= generateRayAttacks(square, 1, 1, blockers);
-            attacks |= generateRayAttacks(square, -1, 1, blockers);
-            attacks |= generateRayAttacks(square, 1, -1, blockers);
-            attacks |= generateRayAttacks(square, -1, -1, blockers);
-
-            uint64_t attackBits = Intrinsics::pext(attacks, attackMask);
-            assert(attackBits <= UINT16_MAX && "Attack bits are too large.");
-            slidingAttackTable[attackOffset + index] = static_cast<uint16_t>(attackBits);
-        }
-
-        diagonalPextTable[square] = { occupiedMask, attackMask, attackOffset };
-        attackOffset += attackCount;
-    }
-}
-
-void initOrthogonalAttacks(uint32_t &attackOffset) {
-    for (uint8_t square = 0; square < 64; ++square) {
-        // Generate the occupied mask for the square.
-        Bitboard occupiedMask;
-        {
-            uint8_t file = Square::file(square);
-            uint8_t rank = Square::rank(square);
-
-            // Don't need to go all the way to the edge of the board since those squares will not affect the attacks
-            // regardless of if they are occupied or not.
-            for (uint8_t i = 1; i < file; ++i) {
-                occupiedMask.set(Square(i, rank));
-            }
-            for (uint8_t i = file + 1; i < 7; ++i) {
-                occupiedMask.set(Square(i, rank));
-            }
-            for (uint8_t i = 1; i < rank; ++i) {
-                occupiedMask.set(Square(file, i));
-            }
-            for (uint8_t i = rank + 1; i < 7; ++i) {
-                occupiedMask.set(Square(file, i));
-            }
-        }
-
-        // Generate the attack mask for the square.
-        Bitboard attackMask;
-        attackMask |= generateRayAttacks(square, 1, 0, 0);
-        attackMask |= generateRayAttacks(square, -1, 0, 0);
-        attackMask |= generateRayAttacks(square, 0, 1, 0);
-        attackMask |= generateRayAttacks(square, 0, -1, 0);
-
-        // Generate all attacks for the square.
-        assert(occupiedMask.count() <= 16 && "Too many occupied squares.");
-        uint16_t attackCount = (1 << occupiedMask.count());
-
-        for (uint16_t index = 0; index < attackCount; ++index) {
-            Bitboard blockers = Intrinsics::pdep(index, occupiedMask);
-
-            Bitboard attacks;
-
-            attacks |= generateRayAttacks(square, 1, 0, blockers);
-            attacks |= generateRayAttacks(square, -1, 0, blockers);
-            attacks |= generateRayAttacks(square, 0, 1, blockers);
-            attacks |= generateRayAttacks(square, 0, -1, blockers);
-
-            uint64_t attackBits = Intrinsics::pext(attacks, attackMask);
-            assert(attackBits <= UINT16_MAX && "Attack bits are too large.");
-            slidingAttackTable[attackOffset + index] = static_cast<uint16_t>(attackBits);
-        }
 
-        orthogonalPextTable[square] = { occupiedMask, attackMask, attackOffset };
-        attackOffset += attackCount;
-    }
-}
-
-void initPawnAttacks() {
-    pawnAttackTable.white().fill(0);
+constexpr ColorMap<SquareMap<Bitboard>> generatePawnAttackTable() {
+    ColorMap<SquareMap<Bitboard>> table;
     for (uint8_t index = 0; index < 64; ++index) {
         Bitboard attacks;
 
@@ -257,10 +97,9 @@ void initPawnAttacks() {
         if (file > 0 && rank < 7) attacks.set(index + 7);
         if (file < 7 && rank < 7) attacks.set(index + 9);
 
-        pawnAttackTable.white()[index] = attacks;
+        table.white()[index] = attacks;
     }
 
-    pawnAttackTable.black().fill(0);
     for (uint8_t index = 0; index < 64; ++index) {
         Bitboard attacks;
 
@@ -270,12 +109,13 @@ void initPawnAttacks() {
         if (file > 0 && rank > 0) attacks.set(index - 9);
         if (file < 7 && rank > 0) attacks.set(index - 7);
 
-        pawnAttackTable.black()[index] = attacks;
+        table.black()[index] = attacks;
     }
+    return table;
 }
 
-void initKnightAttacks() {
-    knightAttackTable.fill(0);
+constexpr SquareMap<Bitboard> generateKnightAttackTable() {
+    SquareMap<Bitboard> table = { };
     for (uint8_t index = 0; index < 64; ++index) {
         Bitboard attacks;
 
@@ -291,12 +131,13 @@ void initKnightAttacks() {
         if (file >= 1 && rank <= 5) attacks.set(index + 15);
         if (file >= 2 && rank <= 6) attacks.set(index + 6);
 
-        knightAttackTable[index] = attacks;
+        table[index] = attacks;
     }
+    return table;
 }
 
-void initKingAttacks() {
-    kingAttackTable.fill(0);
+constexpr SquareMap<Bitboard> generateKingAttackTable() {
+    SquareMap<Bitboard> table = { };
     for (uint8_t index = 0; index < 64; ++index) {
         Bitboard attacks;
 
@@ -312,75 +153,91 @@ void initKingAttacks() {
         if (file <= 6) attacks.set(index + 1);
         if (file <= 6 && rank <= 6) attacks.set(index + 9);
 
-        kingAttackTable[index] = attacks;
+        table[index] = attacks;
     }
+    return table;
 }
 
-} // namespace
+constexpr ColorMap<SquareMap<Bitboard>> PawnAttackTable = generatePawnAttackTable();
+constexpr SquareMap<Bitboard> KnightAttackTable = generateKnightAttackTable();
+constexpr SquareMap<Bitboard> KingAttackTable = generateKingAttackTable();
 
-void Bitboards::init() {
-    initBetweenTable();
-
-    uint32_t attackOffset = 0;
-    initDiagonalAttacks(attackOffset);
-    initOrthogonalAttacks(attackOffset);
-    assert(attackOffset == slidingAttackTable.size() && "Sliding attack table size is incorrect.");
-
-    initPawnAttacks();
-    initKnightAttacks();
-    initKingAttacks();
-}
+} // namespace
 
 
 
 Bitboard Bitboards::between(Square a, Square b) {
-    return Intrinsics::rol(between0x88Table[x88Diff(a, b)], a);
+    return Intrinsics::rol(Between0x88Table[x88Diff(a, b)], a);
 }
 
 
 
 template<Color Side>
 Bitboard Bitboards::pawnAttacks(Square square) {
-    return pawnAttackTable[Side][square];
+    return PawnAttackTable[Side][square];
 }
 
 template Bitboard Bitboards::pawnAttacks<Color::White>(Square);
 template Bitboard Bitboards::pawnAttacks<Color::Black>(Square);
 
 Bitboard Bitboards::knightAttacks(Square square) {
-    return knightAttackTable[square];
+    return KnightAttackTable[square];
 }
 
-Bitboard Bitboards::bishopAttacks(Square square, Bitboard occupied) {
-    const PextTableEntry &entry = diagonalPextTable[square];
+Bitboard Bitboards::Pext::bishopAttacks(Square square, Bitboard occupied) {
+    const SliderTables::PextTableEntry &entry = SliderTables::DiagonalPextTable[square];
 
-    uint16_t attackBits = slidingAttackTable[entry.offset + Intrinsics::pext(occupied, entry.occupiedMask)];
+    uint16_t attackBits = SliderTables::PextAttackTable[entry.offset + Intrinsics::pext(occupied, entry.occupiedMask)];
     return Intrinsics::pdep(attackBits, entry.attackMask);
 }
 
-Bitboard Bitboards::rookAttacks(Square square, Bitboard occupied) {
-    const PextTableEntry &entry = orthogonalPextTable[square];
+Bitboard Bitboards::Pext::rookAttacks(Square square, Bitboard occupied) {
+    const SliderTables::PextTableEntry &entry = SliderTables::OrthogonalPextTable[square];
 
-    uint16_t attackBits = slidingAttackTable[entry.offset + Intrinsics::pext(occupied, entry.occupiedMask)];
+    uint16_t attackBits = SliderTables::PextAttackTable[entry.offset + Intrinsics::pext(occupied, entry.occupiedMask)];
     return Intrinsics::pdep(attackBits, entry.attackMask);
 }
 
+Bitboard Bitboards::Magic::bishopAttacks(Square square, Bitboard occupied) {
+    return SliderTables::MagicAttackTable[SliderTables::DiagonalMagicTable[square].index(occupied)];
+}
+
+Bitboard Bitboards::Magic::rookAttacks(Square square, Bitboard occupied) {
+    return SliderTables::MagicAttackTable[SliderTables::OrthogonalMagicTable[square].index(occupied)];
+}
+
+Bitboard Bitboards::bishopAttacks(Square square, Bitboard occupied) {
+    if constexpr (SelectedSliderBackend == SliderBackend::Pext) {
+        return Pext::bishopAttacks(square, occupied);
+    } else {
+        return Magic::bishopAttacks(square, occupied);
+    }
+}
+
+Bitboard Bitboards::rookAttacks(Square square, Bitboard occupied) {
+    if constexpr (SelectedSliderBackend == SliderBackend::Pext) {
+        return Pext::rookAttacks(square, occupied);
+    } else {
+        return Magic::rookAttacks(square, occupied);
+    }
+}
+
 Bitboard Bitboards::queenAttacks(Square square, Bitboard occupied) {
     return bishopAttacks(square, occupied) | rookAttacks(square, occupied);
 }
 
 Bitboard Bitboards::kingAttacks(Square square) {
-    return kingAttackTable[square];
+    return KingAttackTable[square];
 }
 
 
 
 Bitboard Bitboards::bishopAttacksOnEmpty(Square square) {
-    return diagonalPextTable[square].attackMask;
+    return SliderTables::DiagonalPextTable[square].attackMask;
 }
 
 Bitboard Bitboards::rookAttacksOnEmpty(Square square) {
-    return orthogonalPextTable[square].attackMask;
+    return SliderTables::OrthogonalPextTable[square].attackMask;
 }
 
 Bitboard Bitboards::queenAttacksOnEmpty(Square square) {
@@ -417,6 +274,81 @@ Bitboard Bitboards::allKnightAttacks(Bitboard knights) {
     return attacks;
 }
 
+#ifdef __AVX2__
+namespace {
+
+// Computes the attacks of all the sliders at once with Kogge-Stone occluded fills, one ray direction in each 64-bit lane:
+// https://www.chessprogramming.org/Kogge-Stone_Algorithm#Occluded_Fill
+//
+// Every lane is shifted both left and right. Shifting by 64 or more gives zero, so each lane only has one of the two shifts.
+struct KoggeStoneDirections {
+    __m256i leftShifts;     // Shifts of the directions towards higher square indices, or 64.
+    __m256i rightShifts;    // Shifts of the directions towards lower square indices, or 64.
+    __m256i wrapMasks;      // The squares that a shift can land on without wrapping around to the other side of the board.
+};
+
+INLINE __m256i koggeStoneShift(__m256i bitboards, __m256i leftShifts, __m256i rightShifts) {
+    return _mm256_or_si256(_mm256_sllv_epi64(bitboards, leftShifts), _mm256_srlv_epi64(bitboards, rightShifts));
+}
+
+INLINE Bitboard koggeStoneAttacks(Bitboard sliders, Bitboard occupied, const KoggeStoneDirections &directions) {
+    __m256i leftShifts = directions.leftShifts;
+    __m256i rightShifts = directions.rightShifts;
+
+    __m256i generator = _mm256_set1_epi64x(static_cast<int64_t>(sliders));
+    __m256i propagator = _mm256_andnot_si256(_mm256_set1_epi64x(static_cast<int64_t>(occupied)), directions.wrapMasks);
+
+    // Fill 1, 2, and 4 squares at a time, doubling the shift after every step.
+    generator = _mm256_or_si256(generator, _mm256_and_si256(propagator, koggeStoneShift(generator, leftShifts, rightShifts)));
+    propagator = _mm256_and_si256(propagator, koggeStoneShift(propagator, leftShifts, rightShifts));
+    leftShifts = _mm256_add_epi64(leftShifts, leftShifts);
+    rightShifts = _mm256_add_epi64(rightShifts, rightShifts);
+
+    generator = _mm256_or_si256(generator, _mm256_and_si256(propagator, koggeStoneShift(generator, leftShifts, rightShifts)));
+    propagator = _mm256_and_si256(propagator, koggeStoneShift(propagator, leftShifts, rightShifts));
+    leftShifts = _mm256_add_epi64(leftShifts, leftShifts);
+    rightShifts = _mm256_add_epi64(rightShifts, rightShifts);
+
+    generator = _mm256_or_si256(generator, _mm256_and_si256(propagator, koggeStoneShift(generator, leftShifts, rightShifts)));
+
+    // The attacks are the fill shifted one more square, which includes the blockers.
+    __m256i attacks = _mm256_and_si256(koggeStoneShift(generator, directions.leftShifts, directions.rightShifts),
+        directions.wrapMasks);
+
+    __m128i attacks128 = _mm_or_si128(_mm256_castsi256_si128(attacks), _mm256_extracti128_si256(attacks, 1));
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_or_si128(attacks128, _mm_unpackhi_epi64(attacks128, attacks128))));
+}
+
+// The shifts and wrap masks of the north-east, north-west, south-west, and south-east directions.
+INLINE KoggeStoneDirections diagonalKoggeStoneDirections() {
+    return {
+        _mm256_setr_epi64x(9, 7, 64, 64),
+        _mm256_setr_epi64x(64, 64, 9, 7),
+        _mm256_setr_epi64x(static_cast<int64_t>(~Bitboards::FileA), static_cast<int64_t>(~Bitboards::FileH),
+            static_cast<int64_t>(~Bitboards::FileH), static_cast<int64_t>(~Bitboards::FileA))
+    };
+}
+
+// The shifts and wrap masks of the north, east, south, and west directions.
+INLINE KoggeStoneDirections orthogonalKoggeStoneDirections() {
+    return {
+        _mm256_setr_epi64x(8, 1, 64, 64),
+        _mm256_setr_epi64x(64, 64, 8, 1),
+        _mm256_setr_epi64x(static_cast<int64_t>(Bitboards::All), static_cast<int64_t>(~Bitboards::FileA),
+            static_cast<int64_t>(Bitboards::All), static_cast<int64_t>(~Bitboards::FileH))
+    };
+}
+
+} // namespace
+
+Bitboard Bitboards::allBishopAttacks(Bitboard bishops, Bitboard occupied) {
+    return koggeStoneAttacks(bishops, occupied, diagonalKoggeStoneDirections());
+}
+
+Bitboard Bitboards::allRookAttacks(Bitboard rooks, Bitboard occupied) {
+    return koggeStoneAttacks(rooks, occupied, orthogonalKoggeStoneDirections());
+}
+#else
 Bitboard Bitboards::allBishopAttacks(Bitboard bishops, Bitboard occupied) {
     Bitboard attacks;
     for (Square bishop : bishops) {
@@ -432,22 +364,18 @@ Bitboard Bitboards::allRookAttacks(Bitboard rooks, Bitboard occupied) {
     }
     return attacks;
 }
+#endif // #ifdef __AVX2__
 
 Bitboard Bitboards::allQueenAttacks(Bitboard queens, Bitboard occupied) {
-    Bitboard attacks;
-    for (Square queen : queens) {
-        attacks |= Bitboards::queenAttacks(queen, occupied);
-    }
-    return attacks;
+    return allBishopAttacks(queens, occupied) | allRookAttacks(queens, occupied);
 }
 
 template<Color Side>
 Bitboard Bitboards::allAttacks(const Board &board, Bitboard occupied) {
     return allPawnAttacks<Side>(board.bitboard(Piece::pawn(Side)))
         | allKnightAttacks(board.bitboard(Piece::knight(Side)))
-        | allBishopAttacks(board.bitboard(Piece::bishop(Side)), occupied)
-        | allRookAttacks(board.bitboard(Piece::rook(Side)), occupied)
-        | allQueenAttacks(board.bitboard(Piece::queen(Side)), occupied)
+        | allBishopAttacks(board.bitboard(Piece::bishop(Side)) | board.bitboard(Piece::queen(Side)), occupied)
+        | allRookAttacks(board.bitboard(Piece::rook(Side)) | board.bitboard(Piece::queen(Side)), occupied)
         | kingAttacks(board.king(Side));
 }
 
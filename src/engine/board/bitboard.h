@@ -21,18 +21,18 @@ public:
     INLINE constexpr operator uint64_t() const { return this->set_; } // NOLINT(google-explicit-constructor)
 
     // Returns the number of bits in the bitboard.
-    [[nodiscard]] INLINE uint8_t count() const { return Intrinsics::popcnt(this->set_); }
+    [[nodiscard]] INLINE constexpr uint8_t count() const { return Intrinsics::popcnt(this->set_); }
 
     [[nodiscard]] INLINE constexpr bool get(uint8_t index) const { return (this->set_ & (1ULL << index)) != 0; }
-    INLINE void set(uint8_t index) { this->set_ |= (1ULL << index); }
-    INLINE void clear(uint8_t index) { this->set_ &= ~(1ULL << index); }
+    INLINE constexpr void set(uint8_t index) { this->set_ |= (1ULL << index); }
+    INLINE constexpr void clear(uint8_t index) { this->set_ &= ~(1ULL << index); }
 
     // @formatter:off
-    INLINE Bitboard &operator|=(Bitboard other) { this->set_ |= other.set_; return *this; }
-    INLINE Bitboard &operator&=(Bitboard other) { this->set_ &= other.set_; return *this; }
-    INLINE Bitboard &operator^=(Bitboard other) { this->set_ ^= other.set_; return *this; }
-    INLINE Bitboard &operator<<=(uint8_t shift) { this->set_ <<= shift; return *this; }
-    INLINE Bitboard &operator>>=(uint8_t shift) { this->set_ >>= shift; return *this; }
+    INLINE constexpr Bitboard &operator|=(Bitboard other) { this->set_ |= other.set_; return *this; }
+    INLINE constexpr Bitboard &operator&=(Bitboard other) { this->set_ &= other.set_; return *this; }
+    INLINE constexpr Bitboard &operator^=(Bitboard other) { this->set_ ^= other.set_; return *this; }
+    INLINE constexpr Bitboard &operator<<=(uint8_t shift) { this->set_ <<= shift; return *this; }
+    INLINE constexpr Bitboard &operator>>=(uint8_t shift) { this->set_ >>= shift; return *this; }
     // @formatter:on
 
     // Shifts the bitboard forward/backward by the given number of ranks. Forward is towards the 8th rank for white and towards
@@ -132,8 +132,45 @@ INLINE constexpr Bitboard file(uint8_t file) { return FileA << file; }
 INLINE constexpr Bitboard rank(uint8_t rank) { return Rank1 << (8 * (rank - 1)); }
 // @formatter:on
 
-// Initializes the bitboard tables.
-void init();
+// Returns a bitboard with every square on every file that contains at least one set bit.
+INLINE constexpr Bitboard fileFill(Bitboard bitboard) {
+    uint64_t set = bitboard;
+    set |= set << 8;
+    set |= set << 16;
+    set |= set << 32;
+    set |= set >> 8;
+    set |= set >> 16;
+    set |= set >> 32;
+    return set;
+}
+
+// @formatter:off
+// Implementations of slider attack generation. PEXT bitboards are the fastest on CPUs with fast BMI2 instructions, but PEXT and
+// PDEP are microcoded (and extremely slow) on AMD Zen 1/2, where fancy magic bitboards are much faster.
+enum class SliderBackend : uint8_t {
+    Pext,
+    Magic
+};
+
+// The backend used by bishopAttacks, rookAttacks and queenAttacks. Magic bitboards can be selected with the
+// FKTB_MAGIC_BITBOARDS CMake option, and are always used if the compiler is not targeting BMI2.
+#if defined(__BMI2__) && !defined(FKTB_MAGIC_BITBOARDS)
+constexpr SliderBackend SelectedSliderBackend = SliderBackend::Pext;
+#else
+constexpr SliderBackend SelectedSliderBackend = SliderBackend::Magic;
+#endif
+// @formatter:on
+
+// Both backends are always available regardless of which one is selected, so that they can be benchmarked against each other.
+namespace Pext {
+Bitboard bishopAttacks(Square square, Bitboard occupied);
+Bitboard rookAttacks(Square square, Bitboard occupied);
+} // namespace Pext
+
+namespace Magic {
+Bitboard bishopAttacks(Square square, Bitboard occupied);
+Bitboard rookAttacks(Square square, Bitboard occupied);
+} // namespace Magic
 
 // Returns a bitboard with all the squares between the two given squares, exclusive.
 Bitboard between(Square a, Square b);
@@ -156,7 +193,8 @@ Bitboard rookAttacksOnEmpty(Square square);
 Bitboard bishopAttacksOnEmpty(Square square);
 Bitboard queenAttacksOnEmpty(Square square);
 
-// Returns a bitboard with all attacks of the given piece type.
+// Returns a bitboard with all attacks of the given piece type. With AVX2, the slider attacks of the whole set are computed at once
+// with Kogge-Stone fills instead of looking up each slider's attacks.
 template<Color Side>
 Bitboard allPawnAttacks(Bitboard pawns);
 Bitboard allKnightAttacks(Bitboard knights);
@@ -127,6 +127,9 @@ public:
     // Returns the bitboard of all empty squares.
     [[nodiscard]] INLINE Bitboard empty() const { return ~this->occupied(); }
 
+    // Returns true if the given side has any pieces other than pawns and its king.
+    [[nodiscard]] INLINE bool hasNonPawnMaterial(Color color) const;
+
     // TODO: This function is expensive.
     template<Color Side>
     [[nodiscard]] bool isInCheck() const;
@@ -227,4 +230,9 @@ Bitboard Board::composite(PieceType type) const {
     return this->bitboards_[Color::White][type] | this->bitboards_[Color::Black][type];
 }
 
+INLINE bool Board::hasNonPawnMaterial(Color color) const {
+    const auto &bitboards = this->bitboards_[color];
+    return (bitboards[PieceType::Knight] | bitboards[PieceType::Bishop] | bitboards[PieceType::Rook] | bitboards[PieceType::Queen]) != 0;
+}
+
 } // namespace FKTB
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+
+#include "bitboard.h"
+#include "square.h"
+#include "engine/inline.h"
+#include "engine/intrinsics.h"
+
+// The tables used to look up slider attacks with PEXT bitboards and magic bitboards. The small tables are generated at compile time.
+// The attack tables themselves are too large for that (evaluating them with constexpr takes gigabytes of compiler memory), so they
+// are written to a source file at build time by slider_tables_generator.cc, and still end up in read-only memory.
+namespace FKTB::SliderTables {
+
+// The directions that sliders can move in. Rays in the first four directions go towards higher square indices, so the nearest
+// square on those rays is the least significant bit, and the most significant bit on the other rays.
+// @formatter:off
+enum Direction : uint8_t {
+    North = 0, East = 1, NorthEast = 2, NorthWest = 3,
+    South = 4, West = 5, SouthWest = 6, SouthEast = 7
+};
+// @formatter:on
+
+constexpr std::array<Direction, 4> DiagonalDirections = { NorthEast, NorthWest, SouthWest, SouthEast };
+constexpr std::array<Direction, 4> OrthogonalDirections = { North, East, South, West };
+
+constexpr Bitboard generateEmptyRay(Square square, int8_t fileDelta, int8_t rankDelta) {
+    Bitboard ray;
+
+    int32_t file = Square::file(square) + fileDelta;
+    int32_t rank = Square::rank(square) + rankDelta;
+
+    while (file >= 0 && file <= 7 && rank >= 0 && rank <= 7) {
+        ray.set(Square(file, rank));
+
+        file += fileDelta;
+        rank += rankDelta;
+    }
+
+    return ray;
+}
+
+constexpr SquareMap<std::array<Bitboard, 8>> generateRayTable() {
+    SquareMap<std::array<Bitboard, 8>> table = { };
+    for (uint8_t square = 0; square < 64; ++square) {
+        table[square][North] = generateEmptyRay(square, 0, 1);
+        table[square][East] = generateEmptyRay(square, 1, 0);
+        table[square][NorthEast] = generateEmptyRay(square, 1, 1);
+        table[square][NorthWest] = generateEmptyRay(square, -1, 1);
+        table[square][South] = generateEmptyRay(square, 0, -1);
+        table[square][West] = generateEmptyRay(square, -1, 0);
+        table[square][SouthWest] = generateEmptyRay(square, -1, -1);
+        table[square][SouthEast] = generateEmptyRay(square, 1, -1);
+    }
+    return table;
+}
+
+// Rays on an empty board, only used to generate the other tables.
+constexpr SquareMap<std::array<Bitboard, 8>> RayTable = generateRayTable();
+
+// Returns the attacks along a ray, up to and including the nearest blocker.
+constexpr Bitboard generateRayAttacks(Square square, Direction direction, Bitboard blockers) {
+    Bitboard ray = RayTable[square][direction];
+    Bitboard rayBlockers = ray & blockers;
+    if (rayBlockers == 0) {
+        return ray;
+    }
+
+    Square nearest = (direction < South) ? Intrinsics::bsf(rayBlockers) : Intrinsics::bsr(rayBlockers);
+    return ray ^ RayTable[nearest][direction];
+}
+
+constexpr Bitboard generateSliderAttacks(Square square, const std::array<Direction, 4> &directions, Bitboard blockers) {
+    Bitboard attacks;
+    for (Direction direction : directions) {
+        attacks |= generateRayAttacks(square, direction, blockers);
+    }
+    return attacks;
+}
+
+// The squares that can block a slider. The last square of each ray does not need to be included, since it does not affect the
+// attacks regardless of if it is occupied or not.
+constexpr Bitboard generateOccupiedMask(Square square, const std::array<Direction, 4> &directions) {
+    Bitboard occupiedMask;
+    for (Direction direction : directions) {
+        Bitboard ray = RayTable[square][direction];
+        if (ray == 0) {
+            continue;
+        }
+
+        Square last = (direction < South) ? Intrinsics::bsr(ray) : Intrinsics::bsf(ray);
+        occupiedMask |= ray;
+        occupiedMask.clear(last);
+    }
+    return occupiedMask;
+}
+
+
+
+// Using PEXT bitboards for generating sliding piece attacks: https://www.chessprogramming.org/BMI2#PEXTBitboards
+// (similar to magic bitboards, but without the magic :) )
+struct PextTableEntry {
+    Bitboard occupiedMask;  // The mask of occupied squares.
+    Bitboard attackMask;    // Attacks on an empty board.
+    uint32_t offset;        // The offset into the attack table.
+
+    constexpr PextTableEntry() : occupiedMask(0), attackMask(0), offset(0) { }
+    constexpr PextTableEntry(Bitboard occupiedMask, Bitboard attackMask, uint32_t offset) : occupiedMask(occupiedMask),
+                                                                                            attackMask(attackMask),
+                                                                                            offset(offset) { }
+
+    // The number of entries in the attack table for this square.
+    [[nodiscard]] INLINE constexpr uint32_t attackCount() const {
+        return 1 << this->occupiedMask.count();
+    }
+};
+
+constexpr SquareMap<PextTableEntry> generatePextTable(const std::array<Direction, 4> &directions, uint32_t attackOffset) {
+    SquareMap<PextTableEntry> table = { };
+    for (uint8_t square = 0; square < 64; ++square) {
+        Bitboard occupiedMask = generateOccupiedMask(square, directions);
+        Bitboard attackMask = generateSliderAttacks(square, directions, 0);
+
+        table[square] = { occupiedMask, attackMask, attackOffset };
+        attackOffset += table[square].attackCount();
+    }
+    return table;
+}
+
+constexpr SquareMap<PextTableEntry> DiagonalPextTable = generatePextTable(DiagonalDirections, 0);       // 1.5 KiB
+constexpr SquareMap<PextTableEntry> OrthogonalPextTable = generatePextTable(OrthogonalDirections,     // 1.5 KiB
+    DiagonalPextTable[63].offset + DiagonalPextTable[63].attackCount());
+
+constexpr uint32_t SlidingAttackTableSize = 107648;
+static_assert(OrthogonalPextTable[63].offset + OrthogonalPextTable[63].attackCount() == SlidingAttackTableSize,
+    "Sliding attack table size is incorrect.");
+
+// Using fancy magic bitboards as an alternative to PEXT bitboards for CPUs where PEXT is slow:
+// https://www.chessprogramming.org/Magic_Bitboards#Fancy
+//
+// The magics hash the relevant occupied squares to the same number of bits that PEXT would extract, so both tables have the same
+// size and share the same offsets (only the order of the entries within each square's slice differs).
+struct MagicTableEntry {
+    Bitboard occupiedMask;  // The mask of occupied squares.
+    uint64_t magic;         // The magic number.
+    uint8_t shift;          // 64 minus the number of bits in the occupied mask.
+    uint32_t offset;        // The offset into the attack table.
+
+    constexpr MagicTableEntry() : occupiedMask(0), magic(0), shift(0), offset(0) { }
+    constexpr MagicTableEntry(Bitboard occupiedMask, uint64_t magic, uint32_t offset) : occupiedMask(occupiedMask),
+                                                                                        magic(magic),
+                                                                                        shift(64 - occupiedMask.count()),
+                                                                                        offset(offset) { }
+
+    [[nodiscard]] INLINE constexpr uint32_t index(Bitboard occupied) const {
+        return this->offset + static_cast<uint32_t>(((occupied & this->occupiedMask) * this->magic) >> this->shift);
+    }
+};
+
+// @formatter:off
+constexpr SquareMap<uint64_t> DiagonalMagics = {
+    0x04C4380860440140ULL, 0x002002020A0C2000ULL, 0x8021021400402002ULL, 0x8004242280404200ULL,
+    0x0804030800108200ULL, 0x2001040240080080ULL, 0x0001040104400808ULL, 0x0084808800900444ULL,
+    0x1200100411980200ULL, 0x0000B01080908480ULL, 0x0005088081020090ULL, 0x1091041C21828802ULL,
+    0x0004020210240020ULL, 0x3081011002101580ULL, 0x1500408824100408ULL, 0x2420020100880540ULL,
+    0x0860904002840122ULL, 0x8022003110021082ULL, 0x2042001004001820ULL, 0x4A0800A402102440ULL,
+    0x0884000A00940008ULL, 0x0912006022100200ULL, 0x0411044200822000ULL, 0x0002012101092100ULL,
+    0x00A0840808080800ULL, 0x0204022004080801ULL, 0x1118020001020200ULL, 0x0022008028008002ULL,
+    0x2001001021004000ULL, 0x4000820181004216ULL, 0x00209122008C1000ULL, 0x00C04206A0808400ULL,
+    0x0A01082000082001ULL, 0x0449043088421004ULL, 0x2000180600240C00ULL, 0x000B200800030811ULL,
+    0x80840040101C0100ULL, 0x8012080600204040ULL, 0x0808880040010100ULL, 0x0018309282010040ULL,
+    0x0428040484066080ULL, 0x6202085404500200ULL, 0x2400824240420800ULL, 0x820400D148003400ULL,
+    0x4240200410404C00ULL, 0x081116180A010040ULL, 0x0C60084604A00040ULL, 0x028102020A000049ULL,
+    0x400480842021C040ULL, 0x0002020124421984ULL, 0x4100410088041048ULL, 0x0040800084040400ULL,
+    0x8200011002020416ULL, 0x05480810010A0A11ULL, 0x0010101148428000ULL, 0xA002840802004040ULL,
+    0x0002020622020210ULL, 0x0000228048280401ULL, 0x0102500044041122ULL, 0x4421100400420880ULL,
+    0x2803001C04104414ULL, 0x0002453012108104ULL, 0x0210C00508120441ULL, 0x3040010400820040ULL
+};
+
+constexpr SquareMap<uint64_t> OrthogonalMagics = {
+    0x8080102040008000ULL, 0x5440041000200048ULL, 0x008020008010000AULL, 0x0200084200100420ULL,
+    0x0200081020040200ULL, 0x0600019002002824ULL, 0x040050811008020CULL, 0x0100004881000126ULL,
+    0x0005800440008020ULL, 0x2882002042090880ULL, 0x0002802000801004ULL, 0x0240808010000800ULL,
+    0x4480800800040082ULL, 0x0408808004000200ULL, 0x00BA0004A8020001ULL, 0x1106000042040091ULL,
+    0x0020208010400080ULL, 0x0022060045028020ULL, 0x0020008020100080ULL, 0x0202020008102041ULL,
+    0x0C50808008000400ULL, 0x0068808002000400ULL, 0x00510400C8100201ULL, 0x400006000100A444ULL,
+    0x483424818008400AULL, 0x8840008080200040ULL, 0x0800100080802000ULL, 0x0440100080800800ULL,
+    0x4000080080040080ULL, 0x9124040080020080ULL, 0x0089000300040E00ULL, 0x080001020020488CULL,
+    0x9040002040800080ULL, 0x80D0002001400242ULL, 0x0000401901002002ULL, 0x0030220901001000ULL,
+    0x0080580005003100ULL, 0x0022006C0A001008ULL, 0x0802301144001248ULL, 0x0020010042000084ULL,
+    0x4AC0400084228004ULL, 0x0010004020004000ULL, 0x3110004020010100ULL, 0x0598100009050020ULL,
+    0x4200080011010004ULL, 0x0818020004008080ULL, 0x02A0708102040008ULL, 0x5201010080420004ULL,
+    0x100B124063800100ULL, 0x7808200240048980ULL, 0x8800200010008080ULL, 0x1099201001000900ULL,
+    0x0100050010080100ULL, 0x0400800200040080ULL, 0x2040280190020400ULL, 0x00100C0100608200ULL,
+    0x0000201241088202ULL, 0x1040002042801B01ULL, 0x0124090010200041ULL, 0x0831002004081001ULL,
+    0x2003000800021005ULL, 0x80010002040008C1ULL, 0x0208008122081004ULL, 0x4000008844002102ULL
+};
+// @formatter:on
+
+constexpr SquareMap<MagicTableEntry> generateMagicTable(const SquareMap<PextTableEntry> &pextTable,
+    const SquareMap<uint64_t> &magics) {
+    SquareMap<MagicTableEntry> table = { };
+    for (uint8_t square = 0; square < 64; ++square) {
+        table[square] = { pextTable[square].occupiedMask, magics[square], pextTable[square].offset };
+    }
+    return table;
+}
+
+constexpr SquareMap<MagicTableEntry> DiagonalMagicTable = generateMagicTable(DiagonalPextTable, DiagonalMagics);
+constexpr SquareMap<MagicTableEntry> OrthogonalMagicTable = generateMagicTable(OrthogonalPextTable, OrthogonalMagics);
+
+// Total 210.25 KiB for PEXT bitboards, and 841 KiB for magic bitboards. Defined in the generated slider_tables.cc.
+extern const std::array<uint16_t, SlidingAttackTableSize> PextAttackTable;
+extern const std::array<Bitboard, SlidingAttackTableSize> MagicAttackTable;
+
+} // namespace FKTB::SliderTables
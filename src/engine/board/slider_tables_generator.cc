@@ -0,0 +1,102 @@
+// Writes the slider attack tables (see slider_tables.h) to the source file given as the only argument. Built for and run on the host
+// at build time, so it is not part of the engine variants.
+
+#include <cstdint>
+#include <cstdlib>
+#include <array>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+
+#include "slider_tables.h"
+#include "bitboard.h"
+#include "square.h"
+#include "engine/intrinsics.h"
+
+namespace FKTB::SliderTables {
+
+namespace {
+
+// Fills in the attack tables of one slider, by enumerating every subset of the occupied mask with the Carry-Rippler trick:
+// https://www.chessprogramming.org/Traversing_Subsets_of_a_Set#All_Subsets_of_any_Set
+//
+// The subsets are enumerated in the same order as the PEXT indices, so the i-th subset is stored at PEXT index i. Returns false if
+// a magic number maps two occupancies with different attacks to the same entry.
+bool generateSlidingAttacks(std::vector<uint16_t> &pextTable, std::vector<uint64_t> &magicTable, std::vector<bool> &magicUsed,
+    const std::array<Direction, 4> &directions, const SquareMap<PextTableEntry> &pextEntries,
+    const SquareMap<MagicTableEntry> &magicEntries) {
+    for (uint8_t square = 0; square < 64; ++square) {
+        const PextTableEntry &entry = pextEntries[square];
+
+        Bitboard blockers = 0;
+        uint32_t index = 0;
+        do {
+            Bitboard attacks = generateSliderAttacks(square, directions, blockers);
+
+            pextTable[entry.offset + index] = static_cast<uint16_t>(Intrinsics::softwarePext(attacks, entry.attackMask));
+
+            uint32_t magicIndex = magicEntries[square].index(blockers);
+            if (magicUsed[magicIndex] && magicTable[magicIndex] != attacks) {
+                std::cerr << "Bad magic number for square " << static_cast<uint32_t>(square) << "." << std::endl;
+                return false;
+            }
+            magicTable[magicIndex] = attacks;
+            magicUsed[magicIndex] = true;
+
+            blockers = (blockers - entry.occupiedMask) & entry.occupiedMask;
+            ++index;
+        } while (blockers != 0);
+    }
+
+    return true;
+}
+
+template<typename T>
+void writeTable(std::ostream &out, const char *type, const char *name, const std::vector<T> &table, uint32_t digits) {
+    out << "constexpr std::array<" << type << ", SlidingAttackTableSize> " << name << " = {";
+    for (size_t i = 0; i < table.size(); ++i) {
+        out << ((i % 8 == 0) ? "\n    " : " ") << "0x" << std::setw(digits) << std::setfill('0') << std::hex
+            << static_cast<uint64_t>(table[i]) << std::dec << ",";
+    }
+    out << "\n};\n";
+}
+
+} // namespace
+
+} // namespace FKTB::SliderTables
+
+int main(int argc, char **argv) {
+    using namespace FKTB::SliderTables;
+
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <output file>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<uint16_t> pextTable(SlidingAttackTableSize);
+    std::vector<uint64_t> magicTable(SlidingAttackTableSize);
+    std::vector<bool> magicUsed(SlidingAttackTableSize);
+    if (!generateSlidingAttacks(pextTable, magicTable, magicUsed, DiagonalDirections, DiagonalPextTable, DiagonalMagicTable) ||
+        !generateSlidingAttacks(pextTable, magicTable, magicUsed, OrthogonalDirections, OrthogonalPextTable,
+            OrthogonalMagicTable)) {
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream out(argv[1]);
+    out << "// Generated by slider_tables_generator.cc, do not edit.\n\n"
+        << "#include \"engine/board/slider_tables.h\"\n\n"
+        << "namespace FKTB::SliderTables {\n\n";
+    writeTable(out, "uint16_t", "PextAttackTable", pextTable, 4);
+    out << "\n";
+    writeTable(out, "Bitboard", "MagicAttackTable", magicTable, 16);
+    out << "\n} // namespace FKTB::SliderTables\n";
+
+    if (!out) {
+        std::cerr << "Could not write " << argv[1] << "." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,6 +1,12 @@
 #include "evaluation.h"
 
 #include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <array>
+#include <vector>
+#include <thread>
+#include <algorithm>
 
 #include "game_phase.h"
 #include "engine/inline.h"
@@ -11,90 +17,68 @@ namespace FKTB {
 
 namespace {
 
+// Returns the first pawn shield mask (i.e. the pawns on the starting rank in front of the king) for every king square. The mask is
+// empty if the king is not on the first two ranks or is not on either wing, in which case there is no pawn shield to evaluate.
 template<Color Side>
-INLINE int32_t evaluatePawnShield(const Board &board);
+constexpr SquareMap<Bitboard> generatePawnShieldMasks() {
+    constexpr Bitboard ShieldRank = (Side == Color::White) ? Bitboards::Rank2 : Bitboards::Rank7;
+    constexpr Bitboard KingSide = Bitboards::FileF | Bitboards::FileG | Bitboards::FileH;
+    constexpr Bitboard QueenSide = Bitboards::FileA | Bitboards::FileB | Bitboards::FileC;
+
+    SquareMap<Bitboard> masks = { };
+    for (uint8_t square = 0; square < 64; square++) {
+        uint8_t file = Square::file(square);
+        uint8_t rank = (Side == Color::White) ? Square::rank(square) : (7 - Square::rank(square));
+
+        // Only evaluate pawn shield if king is on first two ranks.
+        if (rank > 1) {
+            continue;
+        }
 
-// Evaluates the pawn shield for the given side, with a bitboard mask for the first pawn shield (i.e. the pawns on the starting
-// rank in front of the king).
-template<Color Side, uint64_t Mask>
-INLINE int32_t evaluatePawnShieldWithMask(const Board &board) {
-    constexpr Color Enemy = ~Side;
-    constexpr Bitboard Mask2 = Bitboard(Mask).shiftForward<Side>(1);
+        if (file >= 5) { // King is on the king-side.
+            masks[square] = ShieldRank & KingSide;
+        } else if (file <= 2) { // King is on the queen-side.
+            masks[square] = ShieldRank & QueenSide;
+        }
+    }
+    return masks;
+}
 
-    int32_t score = 0;
+constexpr ColorMap<SquareMap<Bitboard>> PawnShieldMasks(generatePawnShieldMasks<Color::White>(),
+    generatePawnShieldMasks<Color::Black>());
 
-    Bitboard pawns = board.bitboard(Piece::pawn(Side));
-    Bitboard pawnShield1 = pawns & Mask;
-    Bitboard pawnShield2 = pawns & Mask2;
+// Evaluates the pawn shield for the given side.
+//
+// This is written without any branches (the shield is selected with a table lookup, and open files are found with a file fill)
+// so that the batched evaluation can run it over arrays of positions.
+template<Color Side>
+INLINE int32_t evaluatePawnShield(Square king, Bitboard pawns, Bitboard enemyPawns, Bitboard enemyRooks) {
+    Bitboard mask = PawnShieldMasks[Side][king];
+    Bitboard mask2 = mask.shiftForward<Side>(1);
+
+    Bitboard pawnShield1 = pawns & mask;
+    Bitboard pawnShield2 = pawns & mask2;
 
     // Remove doubled pawns from the second pawn shield.
     pawnShield2 &= ~pawnShield1.shiftForward<Side>(1);
 
-    Bitboard missingShields = ~(pawnShield1 | pawnShield2.shiftBackward<Side>(1)) & Mask;
-
-    uint8_t pawnShield1Count = pawnShield1.count();
-    uint8_t pawnShield2Count = pawnShield2.count();
-    uint8_t missingShieldCount = missingShields.count();
-
-    score += 10 * pawnShield1Count;
-    score += 8 * pawnShield2Count;
-    score -= 8 * missingShieldCount;
-
-    Bitboard enemyPawns = board.bitboard(Piece::pawn(Enemy));
-    Bitboard enemyRooks = board.bitboard(Piece::rook(Enemy));
-    for (Square missingShield : missingShields) {
-        Bitboard file = Bitboards::file(missingShield.file());
+    Bitboard missingShields = ~(pawnShield1 | pawnShield2.shiftBackward<Side>(1)) & mask;
 
-        // Penalty for enemy having an open file on the same file as a missing pawn shield.
-        if (!(enemyPawns & file)) {
-            score -= 8;
+    // Penalty for enemy having an open file on the same file as a missing pawn shield, and an even larger penalty if there is a
+    // rook on the file. All shield squares are on different files, so counting squares is the same as counting files.
+    Bitboard openMissingShields = missingShields & ~Bitboards::fileFill(enemyPawns);
+    Bitboard rookMissingShields = openMissingShields & Bitboards::fileFill(enemyRooks);
 
-            // Even larger penalty if there is a rook on the file.
-            if (enemyRooks & file) {
-                score -= 8;
-            }
-        }
-    }
+    int32_t score = 0;
+    score += 10 * pawnShield1.count();
+    score += 8 * pawnShield2.count();
+    score -= 8 * missingShields.count();
+    score -= 8 * openMissingShields.count();
+    score -= 8 * rookMissingShields.count();
 
     return score;
 }
 
-template<>
-INLINE int32_t evaluatePawnShield<Color::White>(const Board &board) {
-    Square king = board.king(Color::White);
-
-    // Only evaluate pawn shield if king is on first two ranks.
-    if (king.rank() > 1) {
-        return 0;
-    }
-
-    if (king.file() >= 5) { // King is on the king-side.
-        return evaluatePawnShieldWithMask<Color::White, Bitboards::F2 | Bitboards::G2 | Bitboards::H2>(board);
-    } else if (king.file() <= 2) { // King is on the queen-side.
-        return evaluatePawnShieldWithMask<Color::White, Bitboards::A2 | Bitboards::B2 | Bitboards::C2>(board);
-    } else {
-        return 0;
-    }
-}
-
-template<>
-INLINE int32_t evaluatePawnShield<Color::Black>(const Board &board) {
-    Square king = board.king(Color::Black);
-
-    // Only evaluate pawn shield if king is on first two ranks.
-    if (king.rank() < 6) {
-        return 0;
-    }
-
-    if (king.file() >= 5) { // King is on the king-side.
-        return evaluatePawnShieldWithMask<Color::Black, Bitboards::F7 | Bitboards::G7 | Bitboards::H7>(board);
-    } else if (king.file() <= 2) { // King is on the queen-side.
-        return evaluatePawnShieldWithMask<Color::Black, Bitboards::A7 | Bitboards::B7 | Bitboards::C7>(board);
-    } else {
-        return 0;
-    }
-}
-
 
 
 struct KingAttackSquareData {
@@ -214,18 +198,28 @@ INLINE int32_t evaluateKingAttack(const Board &board) {
 
 
 
-// Evaluates the king safety for the given side.
+// Evaluates the king's position for the given side (everything in king safety except for the enemy's attack on the king).
 template<Color Side>
-INLINE int32_t evaluateKingSafety(const Board &board) {
+INLINE int32_t evaluateKingPosition(Square king, Bitboard pawns, Bitboard enemyPawns, Bitboard enemyRooks) {
     int32_t score = 0;
 
     // Penalty for being in the center.
-    Square king = board.king(Side);
-    if ((3 <= king.file()) && (king.file() <= 4)) {
-        score -= 40;
-    }
+    score -= 40 * ((3 <= king.file()) & (king.file() <= 4));
+
+    score += evaluatePawnShield<Side>(king, pawns, enemyPawns, enemyRooks);
+
+    return score;
+}
+
+// Evaluates the king safety for the given side.
+template<Color Side>
+INLINE int32_t evaluateKingSafety(const Board &board) {
+    constexpr Color Enemy = ~Side;
+
+    int32_t score = 0;
 
-    score += evaluatePawnShield<Side>(board);
+    score += evaluateKingPosition<Side>(board.king(Side), board.bitboard(Piece::pawn(Side)), board.bitboard(Piece::pawn(Enemy)),
+        board.bitboard(Piece::rook(Enemy)));
     score += evaluateKingAttack<Side>(board);
 
     return score;
@@ -233,6 +227,8 @@ INLINE int32_t evaluateKingSafety(const Board &board) {
 
 
 
+constexpr int32_t TempoBonus = 20;
+
 // Stage 1 of lazy evaluation (fast evaluation)
 template<GamePhase Phase, Color Side>
 INLINE int32_t evaluateFastForSide(const Board &board) {
@@ -257,7 +253,6 @@ int32_t evaluateFast(const Board &board) {
 
     // Tempo bonus
     if constexpr (Phase == GamePhase::Opening) {
-        constexpr int32_t TempoBonus = 20;
         score += TempoBonus;
     }
 
@@ -336,4 +331,105 @@ int32_t Evaluation::evaluate(const Board &board, int32_t alpha, int32_t beta) {
 template int32_t Evaluation::evaluate<Color::White>(const Board &, int32_t, int32_t);
 template int32_t Evaluation::evaluate<Color::Black>(const Board &, int32_t, int32_t);
 
+
+
+namespace {
+
+// Positions are evaluated in blocks so that the arrays of one block stay in the L1 cache between passes.
+constexpr size_t BatchBlockSize = 256;
+
+// Splitting a batch across threads is only worth the cost of spawning the threads if each thread gets at least this many
+// positions.
+constexpr size_t MinBatchSizePerThread = 16384;
+
+// A block of positions laid out as a structure of arrays. Evaluation terms are all from white's perspective.
+struct BatchBlock {
+    alignas(64) std::array<int32_t, BatchBlockSize> phase;
+    alignas(64) std::array<int32_t, BatchBlockSize> sign;       // 1 if white is to move, -1 if black is to move.
+    alignas(64) std::array<int32_t, BatchBlockSize> opening;
+    alignas(64) std::array<int32_t, BatchBlockSize> end;
+
+    alignas(64) ColorMap<std::array<Bitboard, BatchBlockSize>> pawns;
+    alignas(64) ColorMap<std::array<Bitboard, BatchBlockSize>> rooks;
+    alignas(64) ColorMap<std::array<Square, BatchBlockSize>> kings;
+};
+
+void evaluateBlock(const Board *boards, size_t count, int32_t *scores) {
+    assert(count <= BatchBlockSize);
+
+    BatchBlock block;
+
+    // Pass 1: Gather everything we need from the boards. Material and piece square tables are already incrementally updated by
+    // the board, so this is mostly loads. The enemy's attack on the king has to look at each piece, so it is done here as well.
+    for (size_t i = 0; i < count; i++) {
+        const Board &board = boards[i];
+
+        block.phase[i] = TaperedEval::calculateContinuousPhase(board);
+        block.sign[i] = 1 - 2 * static_cast<int32_t>(board.turn());
+
+        block.opening[i] = evaluateFastForSide<GamePhase::Opening, Color::White>(board)
+            - evaluateFastForSide<GamePhase::Opening, Color::Black>(board)
+            + evaluateKingAttack<Color::White>(board) - evaluateKingAttack<Color::Black>(board);
+        block.end[i] = evaluateFastForSide<GamePhase::End, Color::White>(board)
+            - evaluateFastForSide<GamePhase::End, Color::Black>(board);
+
+        block.pawns.white()[i] = board.bitboard(Piece::pawn(Color::White));
+        block.pawns.black()[i] = board.bitboard(Piece::pawn(Color::Black));
+        block.rooks.white()[i] = board.bitboard(Piece::rook(Color::White));
+        block.rooks.black()[i] = board.bitboard(Piece::rook(Color::Black));
+        block.kings.white()[i] = board.king(Color::White);
+        block.kings.black()[i] = board.king(Color::Black);
+    }
+
+    // Pass 2: King position (pawn shield and center penalty). Only bitboard arithmetic over the arrays.
+    for (size_t i = 0; i < count; i++) {
+        block.opening[i] += evaluateKingPosition<Color::White>(block.kings.white()[i], block.pawns.white()[i],
+            block.pawns.black()[i], block.rooks.black()[i]);
+        block.opening[i] -= evaluateKingPosition<Color::Black>(block.kings.black()[i], block.pawns.black()[i],
+            block.pawns.white()[i], block.rooks.white()[i]);
+    }
+
+    // Pass 3: Convert to the side to move's perspective and interpolate between the opening and end game.
+    for (size_t i = 0; i < count; i++) {
+        int32_t opening = block.sign[i] * block.opening[i] + TempoBonus;
+        int32_t end = block.sign[i] * block.end[i];
+        int32_t phase = block.phase[i];
+
+        scores[i] = ((opening * (256 - phase)) + (end * phase)) / 256;
+    }
+}
+
+void evaluateRange(const Board *boards, size_t count, int32_t *scores) {
+    for (size_t offset = 0; offset < count; offset += BatchBlockSize) {
+        evaluateBlock(boards + offset, std::min(BatchBlockSize, count - offset), scores + offset);
+    }
+}
+
+} // namespace
+
+void Evaluation::evaluateBatch(const Board *boards, size_t count, int32_t *scores, uint32_t threadCount) {
+    // Don't split the batch into pieces that are too small to be worth a thread.
+    size_t maxThreadCount = std::max<size_t>(count / MinBatchSizePerThread, 1);
+    size_t usedThreadCount = std::clamp<size_t>(threadCount, 1, maxThreadCount);
+
+    if (usedThreadCount == 1) {
+        return evaluateRange(boards, count, scores);
+    }
+
+    size_t chunkSize = (count + usedThreadCount - 1) / usedThreadCount;
+
+    // The calling thread evaluates the first chunk, so we only need to spawn threads for the rest.
+    std::vector<std::thread> threads;
+    threads.reserve(usedThreadCount - 1);
+    for (size_t offset = chunkSize; offset < count; offset += chunkSize) {
+        threads.emplace_back(evaluateRange, boards + offset, std::min(chunkSize, count - offset), scores + offset);
+    }
+
+    evaluateRange(boards, std::min(chunkSize, count), scores);
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
 } // namespace FKTB
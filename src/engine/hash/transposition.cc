@@ -3,7 +3,6 @@
 #include <cstdlib>
 #include <cstdint>
 #include <cstring>
-#include <random>
 #include <array>
 #include <cassert>
 #include <stdexcept>
@@ -16,42 +15,66 @@ namespace FKTB {
 
 namespace {
 
-uint64_t blackToMoveNumber = 0;
-std::array<uint64_t, 16> castlingRightsNumbers;
-std::array<uint64_t, 9> enPassantFileNumbers; // Index 0 is for no en passant.
-ColorMap<PieceTypeMap<SquareMap<uint64_t>>> pieceNumbers;
+// SplitMix64, a simple PRNG that can be evaluated at compile time: https://prng.di.unimi.it/splitmix64.c
+class ZobristGenerator {
+public:
+    constexpr explicit ZobristGenerator(uint64_t seed) : state_(seed) { }
 
-} // namespace
+    constexpr uint64_t operator()() {
+        uint64_t z = (this->state_ += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+private:
+    uint64_t state_;
+};
+
+struct ZobristNumbers {
+    uint64_t blackToMove = 0;
+    std::array<uint64_t, 16> castlingRights = { };
+    std::array<uint64_t, 9> enPassantFile = { }; // Index 0 is for no en passant.
+    ColorMap<PieceTypeMap<SquareMap<uint64_t>>> pieces;
+};
 
-void Zobrist::init() {
+constexpr ZobristNumbers generateZobristNumbers() {
     constexpr uint64_t seed = 0;
 
-    std::mt19937_64 generator(seed);
+    ZobristGenerator generator(seed);
+    ZobristNumbers numbers;
 
-    blackToMoveNumber = generator();
+    numbers.blackToMove = generator();
 
-    for (uint64_t &castlingRightsNumber : castlingRightsNumbers) {
+    for (uint64_t &castlingRightsNumber : numbers.castlingRights) {
         castlingRightsNumber = generator();
     }
 
-    for (uint64_t &enPassantFileNumber : enPassantFileNumbers) {
+    for (uint64_t &enPassantFileNumber : numbers.enPassantFile) {
         enPassantFileNumber = generator();
     }
 
     for (uint8_t piece = 0; piece < 6; piece++) {
         for (uint8_t square = 0; square < 64; square++) {
-            pieceNumbers.white()[static_cast<PieceType>(piece)][square] = generator();
-            pieceNumbers.black()[static_cast<PieceType>(piece)][square] = generator();
+            numbers.pieces.white()[static_cast<PieceType>(piece)][square] = generator();
+            numbers.pieces.black()[static_cast<PieceType>(piece)][square] = generator();
         }
     }
+
+    return numbers;
 }
 
+// Generated at compile time, so that no work needs to be done at startup.
+constexpr ZobristNumbers Numbers = generateZobristNumbers();
+
+} // namespace
+
 uint64_t Zobrist::blackToMove() {
-    return blackToMoveNumber;
+    return Numbers.blackToMove;
 }
 
 uint64_t Zobrist::castlingRights(CastlingRights castlingRights) {
-    return castlingRightsNumbers[castlingRights];
+    return Numbers.castlingRights[castlingRights];
 }
 
 uint64_t Zobrist::enPassantSquare(Square square) {
@@ -63,11 +86,11 @@ uint64_t Zobrist::enPassantSquare(Square square) {
     // If square is invalid:        square = 64, so (64.file() + 1) - (64 >> 6) = 1 - 1 = 0 (index of no en passant)
     // If square is valid e.g. a6:  square = 40, so (40.file() + 1) - (40 >> 6) = 1 - 0 = 1 (index of A file en passant)
     uint8_t index = (square.file() + 1) - (square >> 6);
-    return enPassantFileNumbers[index];
+    return Numbers.enPassantFile[index];
 }
 
 uint64_t Zobrist::piece(Piece piece, Square square) {
-    return pieceNumbers[piece.color()][piece.type()][square];
+    return Numbers.pieces[piece.color()][piece.type()][square];
 }
 
 
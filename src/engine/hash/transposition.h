@@ -13,9 +13,6 @@ namespace FKTB {
 
 namespace Zobrist {
 
-// Initializes the Zobrist hash numbers, if not already initialized.
-void init();
-
 uint64_t blackToMove();
 uint64_t castlingRights(CastlingRights castlingRights);
 uint64_t enPassantSquare(Square square);
@@ -9,57 +9,94 @@
 namespace FKTB::Intrinsics {
 
 // Bit scan forward: returns the index of the least significant bit.
-INLINE uint8_t bsf(uint64_t x) {
+INLINE constexpr uint8_t bsf(uint64_t x) {
     assert(x != 0);
     return __builtin_ctzll(x);
 }
 
 // Bit scan reverse: returns the index of the most significant bit.
-INLINE uint8_t bsr(uint64_t x) {
+INLINE constexpr uint8_t bsr(uint64_t x) {
     assert(x != 0);
     return 63 ^ __builtin_clzll(x);
 }
 
 // Population count: returns the number of set bits in the integer.
-INLINE uint8_t popcnt(uint64_t x) {
+INLINE constexpr uint8_t popcnt(uint64_t x) {
     return __builtin_popcountll(x);
 }
 
 // Byte swap: reverses the order of the bytes in the integer.
-INLINE uint64_t bswap(uint64_t x) {
+INLINE constexpr uint64_t bswap(uint64_t x) {
     return __builtin_bswap64(x);
 }
 
 // Rotate left: rotates the bits of the integer to the left.
-INLINE uint64_t rol(uint64_t x, uint8_t shift) {
-    return x << shift | x >> 64 - shift;
+//
+// The complementary shift is masked so that rotating by 0 is not undefined (and can be evaluated at compile time).
+INLINE constexpr uint64_t rol(uint64_t x, uint8_t shift) {
+    return x << shift | x >> ((64 - shift) & 63);
 }
 
 // Rotate right: rotates the bits of the integer to the right.
-INLINE uint64_t ror(uint64_t x, uint8_t shift) {
-    return x >> shift | x << 64 - shift;
+INLINE constexpr uint64_t ror(uint64_t x, uint8_t shift) {
+    return x >> shift | x << ((64 - shift) & 63);
 }
 
 // Reset lowest set bit: sets the least significant bit to zero.
 // Equivalent to x & (x - 1).
-INLINE uint64_t blsr(uint64_t x) {
-    return x & x - 1;
+INLINE constexpr uint64_t blsr(uint64_t x) {
+    return x & (x - 1);
 }
 
 // Extract lowest set bit: returns the least significant bit.
 // Equivalent to x & (-x).
-INLINE uint64_t blsi(uint64_t x) {
+INLINE constexpr uint64_t blsi(uint64_t x) {
     return x & -x;
 }
 
+// Software implementations of PDEP and PEXT. These are slow, but can be evaluated at compile time.
+INLINE constexpr uint64_t softwarePdep(uint64_t x, uint64_t mask) {
+    uint64_t result = 0;
+    for (uint64_t bit = 1; mask != 0; bit <<= 1) {
+        if (x & bit) {
+            result |= blsi(mask);
+        }
+        mask = blsr(mask);
+    }
+    return result;
+}
+
+INLINE constexpr uint64_t softwarePext(uint64_t x, uint64_t mask) {
+    uint64_t result = 0;
+    for (uint64_t bit = 1; mask != 0; bit <<= 1) {
+        if (x & blsi(mask)) {
+            result |= bit;
+        }
+        mask = blsr(mask);
+    }
+    return result;
+}
+
 // Parallel bits deposit: deposits bits from x into the mask.
+//
+// Falls back to a (slow) software implementation if the compiler is not targeting BMI2.
 INLINE uint64_t pdep(uint64_t x, uint64_t mask) {
+#ifdef __BMI2__
     return _pdep_u64(x, mask);
+#else
+    return softwarePdep(x, mask);
+#endif // #ifdef __BMI2__
 }
 
 // Parallel bits extract: extracts bits from x using the mask.
+//
+// Falls back to a (slow) software implementation if the compiler is not targeting BMI2.
 INLINE uint64_t pext(uint64_t x, uint64_t mask) {
+#ifdef __BMI2__
     return _pext_u64(x, mask);
+#else
+    return softwarePext(x, mask);
+#endif // #ifdef __BMI2__
 }
 
 } // namespace FKTB::Intrinsics
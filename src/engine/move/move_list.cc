@@ -49,7 +49,12 @@ void MovePriorityQueue::remove(Move move) {
 
 
 
-RootMoveList::RootMoveList(MoveEntry *start, MoveEntry *end) : moves_(start, end) { }
+RootMoveList::RootMoveList(MoveEntry *start, MoveEntry *end) : moves_() {
+    this->moves_.reserve(end - start);
+    for (MoveEntry *entry = start; entry != end; entry++) {
+        this->moves_.push_back({ entry->move, entry->score, 0, -INT32_MAX });
+    }
+}
 
 Move RootMoveList::dequeue() {
     // Pop the last move off the list
@@ -69,22 +74,52 @@ void RootMoveList::loadHashMove(const Board &board, const TranspositionTable &ta
         return;
     }
 
-    // We first need to remove the hash move from the list if it is present
-    for (auto it = this->moves_.begin(); it != this->moves_.end(); it++) {
-        if (it->move == entry->bestMove()) {
-            this->moves_.erase(it);
-            break;
-        }
-    }
+    // Move the hash move to the back of the list (keeping its node count), or add it if it is not present
+    auto it = std::find_if(this->moves_.begin(), this->moves_.end(), [entry](const RootMoveEntry &rootMove) {
+        return rootMove.move == entry->bestMove();
+    });
 
-    this->moves_.push_back({ entry->bestMove(), 0 });
+    if (it != this->moves_.end()) {
+        std::rotate(it, it + 1, this->moves_.end());
+    } else {
+        this->moves_.push_back({ entry->bestMove(), 0, 0, -INT32_MAX });
+    }
 }
 
 void RootMoveList::sort() {
     // Sort the moves from lowest to highest score since we pop from the back
-    std::sort(this->moves_.begin(), this->moves_.end(), [](const MoveEntry &a, const MoveEntry &b) {
+    std::sort(this->moves_.begin(), this->moves_.end(), [](const RootMoveEntry &a, const RootMoveEntry &b) {
         return a.score < b.score;
     });
 }
 
+void RootMoveList::sortByLastIteration() {
+    // Stable, so that moves that were not searched yet keep their order. Sorted from worst to best, since we pop from the back.
+    std::stable_sort(this->moves_.begin(), this->moves_.end(), [](const RootMoveEntry &a, const RootMoveEntry &b) {
+        if (a.searchScore != b.searchScore) {
+            return a.searchScore < b.searchScore;
+        }
+
+        return a.nodeCount < b.nodeCount;
+    });
+}
+
+double RootMoveList::nodeFraction(Move move) const {
+    uint64_t totalNodeCount = 0;
+    uint64_t moveNodeCount = 0;
+
+    for (const RootMoveEntry &entry : this->moves_) {
+        totalNodeCount += entry.nodeCount;
+        if (entry.move == move) {
+            moveNodeCount = entry.nodeCount;
+        }
+    }
+
+    if (totalNodeCount == 0) {
+        return 0.0;
+    }
+
+    return static_cast<double>(moveNodeCount) / static_cast<double>(totalNodeCount);
+}
+
 } // namespace FKTB
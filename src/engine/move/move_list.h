@@ -70,9 +70,22 @@ private:
     MoveEntry *end_;
 };
 
+// A root move, along with the results of the last iteration that searched it.
+struct RootMoveEntry {
+    Move move;
+    int32_t score;
+
+    // The number of nodes that were searched under the move, and its score if it raised alpha (otherwise the score is only an upper
+    // bound, and this is -INT32_MAX).
+    uint64_t nodeCount;
+    int32_t searchScore;
+
+    RootMoveEntry() = delete;
+};
+
 // This actually allocates memory on the heap, and sorts the moves ahead of time instead of using a priority queue.
 //
-// It's alright for the root move list to be slow because it's only used once per search.
+// It's alright for the root move list to be slow because it's only used once per iteration.
 class RootMoveList {
 public:
     // Copies the entries.
@@ -91,11 +104,21 @@ public:
     // Sorts the moves in the list (assumes they are already scored).
     void sort();
 
+    // Sorts the moves by the results of the last iteration. The moves that raised alpha are searched first, from the highest
+    // score, since they are the most likely to become the best move. The other moves are sorted by the number of nodes searched
+    // under them, since moves with large subtrees were the hardest to refute. Like sort(), this should be called before
+    // loadHashMove().
+    void sortByLastIteration();
+
+    // Returns the fraction of the nodes searched under all root moves that were searched under the given move, or 0 if no nodes
+    // were searched yet.
+    [[nodiscard]] double nodeFraction(Move move) const;
+
     [[nodiscard]] INLINE auto &moves() { return this->moves_; }
     [[nodiscard]] INLINE const auto &moves() const { return this->moves_; }
 
 private:
-    std::vector<MoveEntry> moves_;
+    std::vector<RootMoveEntry> moves_;
 };
 
 } // namespace FKTB
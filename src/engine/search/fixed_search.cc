@@ -1,101 +1,192 @@
 #include "fixed_search.h"
 
 #include <vector>
+#include <array>
+#include <algorithm>
 #include <optional>
+#include <cassert>
+#include <chrono>
 
 #include "score.h"
+#include "search_parameters.h"
 #include "engine/board/piece.h"
 #include "engine/move/move.h"
 #include "engine/move/move_list.h"
 #include "engine/move/movegen.h"
 #include "engine/move/legality_check.h"
 #include "engine/eval/evaluation.h"
+#include "engine/search/move_ordering/see.h"
 
 namespace FKTB {
 
-FixedDepthSearcher::FixedDepthSearcher(const Board &board, uint16_t depth, TranspositionTable &table, HeuristicTables &heuristics,
-    SearchStatistics &stats) : board_(board.copy()), depth_(depth), table_(table), heuristics_(heuristics), stats_(stats) { }
+namespace {
+
+// The natural logarithm of x >= 1, at compile time. x is divided by two until it is in [1, 2), where the series
+// ln(x) = 2 * (y + y^3 / 3 + y^5 / 5 + ...) with y = (x - 1) / (x + 1) converges quickly.
+constexpr double constexprLog(double x) {
+    uint32_t halvings = 0;
+    while (x >= 2.0) {
+        x /= 2.0;
+        halvings++;
+    }
+
+    auto series = [](double x) {
+        double y = (x - 1.0) / (x + 1.0);
+        double power = y;
+        double sum = 0.0;
+        for (uint32_t n = 1; n < 64; n += 2) {
+            sum += power / n;
+            power *= y * y;
+        }
+        return 2.0 * sum;
+    };
+
+    return halvings * series(2.0) + series(x);
+}
+
+// The base late move reductions, indexed by depth and move number (see SearchParameters::LmrBase). Depths and move numbers beyond
+// the table are clamped, since the reduction grows very slowly there. The table is generated at compile time, since it would
+// otherwise be initialized before FKTB::init() selects a variant, with instructions that the CPU might not support.
+constexpr uint16_t LateMoveReductionTableSize = 64;
+
+using LateMoveReductionTable = std::array<std::array<uint8_t, LateMoveReductionTableSize>, LateMoveReductionTableSize>;
+
+constexpr LateMoveReductionTable generateLateMoveReductionTable() {
+    LateMoveReductionTable table{};
+    for (uint16_t depth = 1; depth < LateMoveReductionTableSize; depth++) {
+        for (uint16_t moveNumber = 1; moveNumber < LateMoveReductionTableSize; moveNumber++) {
+            double reduction = SearchParameters::LmrBase
+                + constexprLog(depth) * constexprLog(moveNumber) / SearchParameters::LmrDivisor;
+            table[depth][moveNumber] = static_cast<uint8_t>(reduction);
+        }
+    }
+
+    return table;
+}
+
+constexpr LateMoveReductionTable LateMoveReductions = generateLateMoveReductionTable();
+
+INLINE int32_t lateMoveReduction(uint16_t depth, uint16_t moveNumber) {
+    return LateMoveReductions[std::min<uint16_t>(depth, LateMoveReductionTableSize - 1)]
+        [std::min<uint16_t>(moveNumber, LateMoveReductionTableSize - 1)];
+}
+
+// Nodes searched with a null window can only prove that the score is above or below beta, so they are never part of the
+// principal variation. Written without beta - alpha, since that overflows for the full window (-INT32_MAX, INT32_MAX) that the
+// leftmost line of the tree is searched with.
+INLINE constexpr bool isPvWindow(int32_t alpha, int32_t beta) {
+    return beta - 1 > alpha;
+}
+
+static_assert(isPvWindow(-INT32_MAX, INT32_MAX), "The full window must be a PV window");
+static_assert(isPvWindow(0, 2), "A window wider than one must be a PV window");
+static_assert(!isPvWindow(0, 1), "A null window must not be a PV window");
+
+} // namespace
+
+
+
+FixedDepthSearcher::FixedDepthSearcher(const Board &board, TranspositionTable &table, HeuristicTables &heuristics,
+    SearchStatistics &stats, uint32_t threadIndex) : board_(board.copy()), depth_(0), table_(table), heuristics_(heuristics),
+                                                     stats_(stats), threadStats_(stats.thread(threadIndex)), stack_() { }
 
 void FixedDepthSearcher::halt() {
     this->isHalted_ = true;
 }
 
+void FixedDepthSearcher::setHaltLimits(const HaltLimits &limits) {
+    std::chrono::steady_clock::time_point deadline = limits.deadline.value_or(std::chrono::steady_clock::time_point::max());
+
+    this->nodeLimit_.store(limits.nodes.value_or(UINT64_MAX), std::memory_order_relaxed);
+    this->deadline_.store(deadline.time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+INLINE void FixedDepthSearcher::countNode() {
+    this->threadStats_.incrementNodeCount();
+
+    if (--this->nodesUntilLimitCheck_ == 0) {
+        this->checkHaltLimits();
+    }
+}
+
+void FixedDepthSearcher::checkHaltLimits() {
+    this->nodesUntilLimitCheck_ = LimitCheckInterval;
+
+    uint64_t nodeLimit = this->nodeLimit_.load(std::memory_order_relaxed);
+    if (nodeLimit != UINT64_MAX) {
+        uint64_t nodeCount = this->stats_.nodeCount();
+
+        if (nodeCount >= nodeLimit) {
+            this->limitReachedAt_ = std::chrono::steady_clock::now();
+            this->halt();
+            return;
+        }
+
+        // Check again exactly when the node limit would be reached, so that the search does not overshoot it
+        this->nodesUntilLimitCheck_ = static_cast<uint32_t>(std::min<uint64_t>(LimitCheckInterval, nodeLimit - nodeCount));
+    }
+
+    auto deadline = std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(this->deadline_.load(std::memory_order_relaxed)));
+    if (deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= deadline) {
+        this->limitReachedAt_ = deadline;
+        this->halt();
+    }
+}
+
 
 
-SearchLine FixedDepthSearcher::search() {
+SearchLine FixedDepthSearcher::search(uint16_t depth) {
     RootMoveList moves = MoveGeneration::generateLegalRoot(this->board_);
 
-    MoveOrdering::score<MoveOrdering::Type::All>(moves, this->board_, &this->heuristics_.history);
+    HistoryContext history(this->heuristics_);
+    MoveOrdering::score<MoveOrdering::Type::All>(moves, this->board_, &history);
     moves.sort();
     moves.loadHashMove(this->board_, this->table_);
 
-    return this->search(std::move(moves));
+    return this->search(depth, moves);
 }
 
-SearchLine FixedDepthSearcher::search(RootMoveList moves) {
-    // Resize the killer table to the depth of the search
-    this->heuristics_.killers.resize(this->depth_);
+SearchLine FixedDepthSearcher::search(uint16_t depth, RootMoveList &moves) {
+    assert(depth > this->depth_ && depth <= MaxSearchDepth);
+
+    this->depth_ = depth;
 
     // Search the root node
     SearchRootNode node = SearchRootNode::invalid();
     if (this->board_.turn() == Color::White) {
-        node = this->searchRoot<Color::White>(std::move(moves));
+        node = this->searchRoot<Color::White>(moves);
     } else {
-        node = this->searchRoot<Color::Black>(std::move(moves));
+        node = this->searchRoot<Color::Black>(moves);
     }
 
-    // Check if the search was halted
+    // Check if the search was halted. If a root move completed and beat the first root move before the search was halted, its line
+    // is still better than the result of the previous iteration.
     if (this->isHalted_) {
-        return SearchLine::invalid();
-    }
-
-    // Find the best line using the transposition table
-    std::vector<Move> bestLine;
-
-    Board board = this->board_.copy();
-    uint16_t depth = this->depth_;
-    Move move = node.move;
-    while (move.isValid()) {
-        // We have to check that the PV move is legal in case of rare hash key collisions (see
-        // https://www.chessprogramming.org/Transposition_Table#KeyCollisions)
-        if (!LegalityCheck::isLegal(board, move)) {
-            break;
-        }
-
-        bestLine.push_back(move);
-
-        board.makeMove<MakeMoveType::All>(move);
-
-        // Find the next best move in the line
-        depth--;
-
-        // Do not allow depth to go below 0, since the best line might just be shuffling back and forth, which would
-        // make this go into an infinite loop
-        if (depth == 0) {
-            break;
+        if (!node.move.isValid()) {
+            return SearchLine::invalid();
         }
 
-        TranspositionTable::Entry *entry = this->table_.load(board.hash());
-        if (entry == nullptr || entry->depth() < depth || entry->flag() != TranspositionTable::Flag::Exact) {
-            break;
-        }
-        move = entry->bestMove();
+        return { this->stack_.root()->pv.moves(), node.score, true };
     }
 
-    return { std::move(bestLine), node.score };
+    return { this->stack_.root()->pv.moves(), node.score };
 }
 
 template<Color Turn>
-SearchRootNode FixedDepthSearcher::searchRoot(RootMoveList moves) {
+SearchRootNode FixedDepthSearcher::searchRoot(RootMoveList &moves) {
     if (this->isHalted_) {
         return SearchRootNode::invalid();
     }
 
-    this->stats_.incrementNodeCount();
+    this->countNode();
 
     uint16_t depth = this->depth_;
     Board &board = this->board_;
     TranspositionTable &table = this->table_;
+    SearchFrame *frame = this->stack_.root();
+
+    frame->pv.clear();
 
     if (moves.empty()) {
         if (board.isInCheck<Turn>()) { // Checkmate
@@ -109,18 +200,43 @@ SearchRootNode FixedDepthSearcher::searchRoot(RootMoveList moves) {
     Move bestMove = Move::invalid();
     int32_t alpha = -INT32_MAX;
 
-    while (!moves.empty()) {
-        Move move = moves.dequeue();
+    // The best move is at the back of the list.
+    for (auto it = moves.moves().rbegin(); it != moves.moves().rend(); ++it) {
+        Move move = it->move;
+        this->setCurrentMove(frame, move);
         MakeMoveInfo info = board.makeMove<MakeMoveType::AllNoTurn>(move);
 
-        int32_t score = -search<~Turn>(depth - 1, 1, -INT32_MAX, -alpha);
+        uint64_t nodeCountBefore = this->threadStats_.nodeCount();
+
+        int32_t score = this->searchMove<Turn>(depth, 0, frame, alpha, INT32_MAX, it == moves.moves().rbegin());
+
+        it->nodeCount = this->threadStats_.nodeCount() - nodeCountBefore;
+
+        board.unmakeMove<MakeMoveType::AllNoTurn>(move, info);
+
+        // The score of a move whose search was halted is meaningless
+        if (this->isHalted_) {
+            break;
+        }
 
         if (score > alpha) {
             bestMove = move;
             alpha = score;
+            frame->pv.update(move, (frame + 1)->pv);
+            it->searchScore = score;
+        } else {
+            it->searchScore = -INT32_MAX;
         }
+    }
 
-        board.unmakeMove<MakeMoveType::AllNoTurn>(move, info);
+    // If the search was halted, only a move that beat the first root move is useful, since the first move is usually the best move
+    // of the previous iteration (the hash move).
+    if (this->isHalted_) {
+        if (bestMove.isValid() && bestMove != moves.moves().back().move) {
+            return { bestMove, alpha };
+        }
+
+        return SearchRootNode::invalid();
     }
 
     // Transposition table store
@@ -131,9 +247,73 @@ SearchRootNode FixedDepthSearcher::searchRoot(RootMoveList moves) {
 
 
 
+INLINE void FixedDepthSearcher::setCurrentMove(SearchFrame *frame, Move move) {
+    frame->currentMove = move;
+
+    if (move.isValid()) {
+        frame->continuation = &this->heuristics_.continuations(this->board_.pieceAt(move.from()), move.to());
+    } else {
+        frame->continuation = nullptr;
+    }
+}
+
 template<Color Turn>
-int32_t FixedDepthSearcher::searchQuiesce(int32_t alpha, int32_t beta) {
-    this->stats_.incrementNodeCount();
+INLINE void FixedDepthSearcher::updateQuietHistories(SearchFrame *frame, Move move, int32_t bonus) {
+    Board &board = this->board_;
+
+    this->heuristics_.history.update(Turn, board, move, bonus);
+
+    for (SearchFrame *previous : { frame - 1, frame - 2 }) {
+        if (previous->continuation != nullptr) {
+            previous->continuation->update(Turn, board, move, bonus);
+        }
+    }
+}
+
+template<Color Turn>
+INLINE void FixedDepthSearcher::updateQuietHeuristics(SearchFrame *frame, Move move, uint16_t depth) {
+    Board &board = this->board_;
+
+    int32_t bonus = HistoryTable::bonus(depth);
+
+    // Reward the move that caused the cutoff, and penalize the quiet moves that were searched before it and did not.
+    this->updateQuietHistories<Turn>(frame, move, bonus);
+    for (uint16_t i = 0; i < frame->searchedQuiets.size(); i++) {
+        this->updateQuietHistories<Turn>(frame, frame->searchedQuiets[i], -bonus);
+    }
+    this->penalizeSearchedCaptures<Turn>(frame, bonus);
+
+    frame->killers.add(move);
+
+    Move previousMove = (frame - 1)->currentMove;
+    if (previousMove.isValid()) {
+        this->heuristics_.countermoves.set(board.pieceAt(previousMove.to()), previousMove.to(), move);
+    }
+}
+
+template<Color Turn>
+INLINE void FixedDepthSearcher::penalizeSearchedCaptures(SearchFrame *frame, int32_t bonus) {
+    for (uint16_t i = 0; i < frame->searchedCaptures.size(); i++) {
+        this->heuristics_.captures.update(Turn, this->board_, frame->searchedCaptures[i], -bonus);
+    }
+}
+
+template<Color Turn>
+INLINE void FixedDepthSearcher::updateCaptureHeuristics(SearchFrame *frame, Move move, uint16_t depth) {
+    int32_t bonus = HistoryTable::bonus(depth);
+
+    // Reward the capture that caused the cutoff, and penalize the captures that were searched before it and did not.
+    this->heuristics_.captures.update(Turn, this->board_, move, bonus);
+    this->penalizeSearchedCaptures<Turn>(frame, bonus);
+}
+
+
+
+template<Color Turn>
+int32_t FixedDepthSearcher::searchQuiesce(int32_t alpha, int32_t beta, uint16_t ply) {
+    this->countNode();
+    this->threadStats_.incrementQuiescenceNodeCount();
+    this->threadStats_.updateSelectiveDepth(ply);
 
     Board &board = this->board_;
 
@@ -142,7 +322,7 @@ int32_t FixedDepthSearcher::searchQuiesce(int32_t alpha, int32_t beta) {
         return beta;
     }
 
-    // Delta pruning
+    // Delta pruning: if even winning a queen could not raise alpha, no capture can
     constexpr int32_t Delta = 1100;
     if (standPat + Delta < alpha) {
         return alpha;
@@ -157,14 +337,34 @@ int32_t FixedDepthSearcher::searchQuiesce(int32_t alpha, int32_t beta) {
     MoveEntry *movesEnd = MoveGeneration::generate<Turn, MoveGeneration::Type::Tactical>(board, movesStart);
 
     MovePriorityQueue moves(movesStart, movesEnd);
-    MoveOrdering::score<Turn, MoveOrdering::Type::Tactical>(moves, board, nullptr);
+    HistoryContext history(this->heuristics_);
+    MoveOrdering::score<Turn, MoveOrdering::Type::Tactical>(moves, board, &history);
 
     // Capture search
     while (!moves.empty()) {
         Move move = moves.dequeue();
+
+        // Per-capture delta pruning: skip captures that cannot raise alpha even if the captured piece is won for free (with a margin
+        // for positional gains). Promotions are never pruned, since they gain more than the captured piece.
+        constexpr int32_t CaptureDelta = 200;
+        if (move.isCapture() && !move.isPromotion()) {
+            PieceType captured = move.isEnPassant() ? PieceType::Pawn : board.pieceAt(move.to()).type();
+
+            if (standPat + PieceMaterial::value(captured) + CaptureDelta <= alpha) {
+                this->threadStats_.incrementQuiescenceDeltaPrunes();
+                continue;
+            }
+        }
+
+        // SEE pruning: captures that lose material are very unlikely to raise alpha, so skip them
+        if (!See::isAtLeast<Turn>(move, board, 0)) {
+            this->threadStats_.incrementQuiescenceSeePrunes();
+            continue;
+        }
+
         MakeMoveInfo info = board.makeMove<MakeMoveType::AllNoTurn>(move);
 
-        int32_t score = -this->searchQuiesce<~Turn>(-beta, -alpha);
+        int32_t score = -this->searchQuiesce<~Turn>(-beta, -alpha, ply + 1);
 
         board.unmakeMove<MakeMoveType::AllNoTurn>(move, info);
 
@@ -179,33 +379,172 @@ int32_t FixedDepthSearcher::searchQuiesce(int32_t alpha, int32_t beta) {
 }
 
 template<Color Turn>
-INLINE int32_t FixedDepthSearcher::searchAlphaBeta(Move &bestMove, Move hashMove, uint16_t depth, uint16_t ply, int32_t &alpha, int32_t beta) {
+INLINE int32_t FixedDepthSearcher::searchMove(uint16_t depth, uint16_t reduction, SearchFrame *frame, int32_t alpha, int32_t beta,
+    bool isFirstMove) {
+    if (isFirstMove) {
+        return -this->search<~Turn>(depth - 1, frame + 1, -beta, -alpha);
+    }
+
+    int32_t score = -this->search<~Turn>(depth - 1 - reduction, frame + 1, -alpha - 1, -alpha);
+
+    // Verify reduced moves that raise alpha with a full-depth search
+    if (reduction > 0 && score > alpha) {
+        score = -this->search<~Turn>(depth - 1, frame + 1, -alpha - 1, -alpha);
+    }
+
+    // At PV nodes, a move that raises alpha without failing high is a new principal variation, so its exact score is needed
+    if (score > alpha && score < beta) {
+        score = -this->search<~Turn>(depth - 1, frame + 1, -beta, -alpha);
+    }
+
+    return score;
+}
+
+template<Color Turn>
+INLINE int32_t FixedDepthSearcher::searchAlphaBeta(Move &bestMove, Move hashMove, uint16_t depth, SearchFrame *frame, int32_t &alpha, int32_t beta) {
     if (depth == 0) {
-        return this->searchQuiesce<Turn>(alpha, beta);
+        return this->searchQuiesce<Turn>(alpha, beta, frame->ply);
     }
 
-    this->stats_.incrementNodeCount();
+    this->countNode();
+    this->threadStats_.updateSelectiveDepth(frame->ply);
 
     Board &board = this->board_;
 
-    // Stage 1: Null move pruning
     bool isInCheck = board.isInCheck<Turn>();
-    if (depth >= 3 && !isInCheck) {
+
+    bool isPvNode = isPvWindow(alpha, beta);
+
+    // Stage 1: Node-level pruning
+    //
+    // The static evaluation is meaningless when in check, since the position is not quiet, so none of these are done in check.
+    if (!isInCheck) {
+        int32_t staticEval = Evaluation::evaluate<Turn>(board, alpha, beta);
+        frame->staticEval = staticEval;
+
+        // Reverse futility pruning. Mate scores are excluded, since failing high on a mate bound based on the evaluation would
+        // claim a mate that does not exist.
+        if constexpr (SearchParameters::ReverseFutilityPruning) {
+            if (!isPvNode && depth <= SearchParameters::ReverseFutilityMaxDepth && !Score::isMate(beta)
+                && staticEval - SearchParameters::reverseFutilityMargin(depth) >= beta) {
+                return beta;
+            }
+        }
+
+        // Razoring
+        if constexpr (SearchParameters::Razoring) {
+            if (!isPvNode && depth <= SearchParameters::RazoringMaxDepth
+                && staticEval + SearchParameters::razoringMargin(depth) < alpha) {
+                int32_t score = this->searchQuiesce<Turn>(alpha, beta, frame->ply);
+                if (score <= alpha) {
+                    return score;
+                }
+            }
+        }
+    }
+
+    // Stage 2: Null move pruning
+    //
+    // Only done if the static evaluation is already at least beta, since otherwise the null move is unlikely to fail high, and
+    // not in positions where the side to move only has pawns, since zugzwang is common there. Like reverse futility pruning, it
+    // is not done for mate bounds.
+    if (depth >= SearchParameters::NullMoveMinDepth && !isInCheck && frame->ply >= this->nullMoveMinPly_ && !Score::isMate(beta)
+        && frame->staticEval >= beta && board.hasNonPawnMaterial(Turn)) {
+        uint16_t reduction = SearchParameters::nullMoveReduction(depth, frame->staticEval, beta);
+        uint16_t reducedDepth = depth > reduction ? depth - reduction : 0;
+
+        this->setCurrentMove(frame, Move::invalid());
         MakeMoveInfo info = board.makeNullMove();
 
         // Pass -beta + 1 as alpha since it is a null window search (see https://www.chessprogramming.org/Null_Window).
-        int32_t score = -this->search<~Turn>(depth - 3, ply + 1, -beta, -beta + 1);
+        int32_t score = -this->search<~Turn>(reducedDepth, frame + 1, -beta, -beta + 1);
 
         board.unmakeNullMove(info);
 
         if (score >= beta) {
-            return beta;
+            if (depth < SearchParameters::NullMoveVerificationDepth || this->nullMoveMinPly_ != 0) {
+                return beta;
+            }
+
+            // Verify the fail-high at high depth by searching the node itself at the reduced depth, with null moves disabled for
+            // the first plies of the verification search. This catches zugzwang positions that still have non-pawn material.
+            //
+            // The verification search uses this node's frame, since it searches the same position at the same ply. Nothing has
+            // been searched from this node yet, so most of the state it overwrites is reset before it is read again: the PV is
+            // empty either way, the searched moves are cleared and the move buffer is regenerated below, and every move sets the
+            // current move before it is searched. The killers it updates are valid killers of this ply. Only the static
+            // evaluation is read again without being recomputed, and the verification search may leave it as Score::None (e.g.
+            // on a transposition table cutoff), so it is restored.
+            int32_t staticEval = frame->staticEval;
+            this->nullMoveMinPly_ = frame->ply + 3 * reducedDepth / 4;
+            int32_t verification = this->search<Turn>(reducedDepth, frame, beta - 1, beta);
+            this->nullMoveMinPly_ = 0;
+            frame->staticEval = staticEval;
+
+            if (verification >= beta) {
+                return beta;
+            }
         }
     }
 
     int32_t bestScore = -INT32_MAX;
+    frame->searchedQuiets.clear();
+    frame->searchedCaptures.clear();
+
+    // Only the first move searched from this node gets the full window (see searchMove)
+    bool hasSearchedMove = false;
+
+    // Stage 3: ProbCut
+    if constexpr (SearchParameters::ProbCut) {
+        int32_t probCutBeta = beta + SearchParameters::ProbCutMargin;
+        uint16_t probCutDepth = depth - SearchParameters::ProbCutReduction;
+
+        bool canProbCut = !isPvNode && !isInCheck && depth >= SearchParameters::ProbCutMinDepth && !Score::isMate(beta);
+
+        // Skip ProbCut if the transposition table already tells us that a search of at least the reduced depth did not beat the
+        // ProbCut beta (the entry may have been replaced during the null move search, so it is loaded again).
+        if (canProbCut) {
+            TranspositionTable::Entry *entry = this->table_.load(board.hash());
+            canProbCut = entry == nullptr || entry->depth() < probCutDepth || entry->flag() == TranspositionTable::Flag::LowerBound
+                || entry->bestScore() >= probCutBeta;
+        }
+
+        if (canProbCut) {
+            MoveEntry *movesEnd = MoveGeneration::generate<Turn, MoveGeneration::Type::Tactical>(board, frame->moves());
 
-    // Stage 2: Hash move
+            MovePriorityQueue moves(frame->moves(), movesEnd);
+            HistoryContext history(this->heuristics_);
+            MoveOrdering::score<Turn, MoveOrdering::Type::Tactical>(moves, board, &history);
+
+            while (!moves.empty()) {
+                Move move = moves.dequeue();
+
+                if (!move.isCapture() || !See::isAtLeast<Turn>(move, board, probCutBeta - frame->staticEval)) {
+                    continue;
+                }
+
+                this->setCurrentMove(frame, move);
+                MakeMoveInfo info = board.makeMove<MakeMoveType::AllNoTurn>(move);
+
+                // Quiescence search first, which is much cheaper and refutes most captures
+                int32_t score = -this->searchQuiesce<~Turn>(-probCutBeta, -probCutBeta + 1, frame->ply + 1);
+                if (score >= probCutBeta) {
+                    score = -this->search<~Turn>(probCutDepth, frame + 1, -probCutBeta, -probCutBeta + 1);
+                }
+
+                board.unmakeMove<MakeMoveType::AllNoTurn>(move, info);
+
+                // The cutoff was only proven at reduced depth, so it is stored with that depth here (bestMove stays invalid, so that
+                // search does not store it again with the full depth).
+                if (score >= probCutBeta) {
+                    this->table_.maybeStore(board.hash(), probCutDepth + 1, TranspositionTable::Flag::LowerBound, move, score);
+                    return beta;
+                }
+            }
+        }
+    }
+
+    // Stage 4: Hash move
     //
     // Try the hash move first, if it exists. We can save all move generation entirely if the hash move causes a beta-cutoff.
     //
@@ -214,31 +553,42 @@ INLINE int32_t FixedDepthSearcher::searchAlphaBeta(Move &bestMove, Move hashMove
     LegalityChecker<Turn> legalityChecker(board);
 
     if (hashMove.isValid() && legalityChecker.isLegal(hashMove)) {
+        this->setCurrentMove(frame, hashMove);
         MakeMoveInfo info = board.makeMove<MakeMoveType::AllNoTurn>(hashMove);
 
-        int32_t score = -this->search<~Turn>(depth - 1, ply + 1, -beta, -alpha);
+        int32_t score = this->searchMove<Turn>(depth, 0, frame, alpha, beta, !hasSearchedMove);
+        hasSearchedMove = true;
 
         board.unmakeMove<MakeMoveType::AllNoTurn>(hashMove, info);
 
         if (score > bestScore) {
             bestScore = score;
             bestMove = hashMove;
-            alpha = std::max(alpha, score);
+            if (score > alpha) {
+                alpha = score;
+                frame->pv.update(hashMove, (frame + 1)->pv);
+            }
         }
 
         if (score >= beta) {
             if (hashMove.isQuiet()) {
-                this->heuristics_.history.add(Turn, board, hashMove, depth);
-                this->heuristics_.killers.add(depth, hashMove);
+                this->updateQuietHeuristics<Turn>(frame, hashMove, depth);
+            } else if (hashMove.isCapture()) {
+                this->updateCaptureHeuristics<Turn>(frame, hashMove, depth);
             }
 
             return bestScore;
         }
+
+        if (hashMove.isQuiet()) {
+            frame->searchedQuiets.push(hashMove);
+        } else if (hashMove.isCapture()) {
+            frame->searchedCaptures.push(hashMove);
+        }
     }
 
-    // Stage 3: Tactical move search
-    AlignedMoveEntry moveBuffer[MaxMoveCount];
-    MoveEntry *movesStart = MoveEntry::fromAligned(moveBuffer);
+    // Stage 5: Tactical move search
+    MoveEntry *movesStart = frame->moves();
 
     bool hasTacticalMoves;
 
@@ -254,58 +604,93 @@ INLINE int32_t FixedDepthSearcher::searchAlphaBeta(Move &bestMove, Move hashMove
             moves.remove(hashMove);
         }
 
-        MoveOrdering::score<Turn, MoveOrdering::Type::Tactical>(moves, board, nullptr);
+        HistoryContext history(this->heuristics_);
+        MoveOrdering::score<Turn, MoveOrdering::Type::Tactical>(moves, board, &history);
 
         // Search all tactical moves
         while (!moves.empty()) {
             Move move = moves.dequeue();
+            this->setCurrentMove(frame, move);
             MakeMoveInfo info = board.makeMove<MakeMoveType::AllNoTurn>(move);
 
-            int32_t score = -this->search<~Turn>(depth - 1, ply + 1, -beta, -alpha);
+            int32_t score = this->searchMove<Turn>(depth, 0, frame, alpha, beta, !hasSearchedMove);
+            hasSearchedMove = true;
 
             board.unmakeMove<MakeMoveType::AllNoTurn>(move, info);
 
             if (score > bestScore) {
                 bestScore = score;
                 bestMove = move;
-                alpha = std::max(alpha, score);
+                if (score > alpha) {
+                    alpha = score;
+                    frame->pv.update(move, (frame + 1)->pv);
+                }
             }
 
             if (score >= beta) {
+                if (move.isCapture()) {
+                    this->updateCaptureHeuristics<Turn>(frame, move, depth);
+                }
+
                 return bestScore;
             }
+
+            if (move.isCapture()) {
+                frame->searchedCaptures.push(move);
+            }
         }
     }
 
-    // Stage 4: Killer moves
-    for (Move killer : this->heuristics_.killers[depth]) {
-        // We already tried the hash move, so skip it if it is also a killer move.
+    // Stage 6: Killer moves and countermove
+    //
+    // The countermove is the quiet move that last refuted the opponent's previous move. It is skipped if it is also a killer move.
+    std::array<Move, KillerMoves::Count + 1> refutations = { Move::invalid(), Move::invalid(), Move::invalid() };
+    std::copy(frame->killers.begin(), frame->killers.end(), refutations.begin());
+
+    Move previousMove = (frame - 1)->currentMove;
+    if (previousMove.isValid()) {
+        Move countermove = this->heuristics_.countermoves.get(board.pieceAt(previousMove.to()), previousMove.to());
+        if (std::find(frame->killers.begin(), frame->killers.end(), countermove) == frame->killers.end()) {
+            refutations.back() = countermove;
+        }
+    }
+
+    for (Move refutation : refutations) {
+        // We already tried the hash move, so skip it if it is also a killer move or the countermove.
         //
         // We also have to check if the killer move is legal, since killers are just moves that caused a beta-cutoff in a sibling
-        // node (or any node on the same ply in general), so it is possible that the killer move is not legal.
-        if (!killer.isValid() || killer == hashMove || !legalityChecker.isLegal(killer)) {
+        // node (or any node on the same ply in general), so it is possible that the killer move is not legal. The same goes for
+        // the countermove.
+        if (!refutation.isValid() || refutation == hashMove || !legalityChecker.isLegal(refutation)) {
             continue;
         }
 
-        MakeMoveInfo info = board.makeMove<MakeMoveType::AllNoTurn>(killer);
+        this->setCurrentMove(frame, refutation);
+        MakeMoveInfo info = board.makeMove<MakeMoveType::AllNoTurn>(refutation);
 
-        int32_t score = -this->search<~Turn>(depth - 1, ply + 1, -beta, -alpha);
+        int32_t score = this->searchMove<Turn>(depth, 0, frame, alpha, beta, !hasSearchedMove);
+        hasSearchedMove = true;
 
-        board.unmakeMove<MakeMoveType::AllNoTurn>(killer, info);
+        board.unmakeMove<MakeMoveType::AllNoTurn>(refutation, info);
 
         if (score > bestScore) {
             bestScore = score;
-            bestMove = killer;
-            alpha = std::max(alpha, score);
+            bestMove = refutation;
+            if (score > alpha) {
+                alpha = score;
+                frame->pv.update(refutation, (frame + 1)->pv);
+            }
         }
 
         if (score >= beta) {
-            this->heuristics_.history.add(Turn, board, killer, depth);
+            this->updateQuietHeuristics<Turn>(frame, refutation, depth);
             return bestScore;
         }
+
+        frame->searchedQuiets.push(refutation);
     }
 
-    // Stage 5: Quiet move search
+    // Stage 7: Quiet move search
     {
         MoveEntry *movesEnd = MoveGeneration::generate<Turn, MoveGeneration::Type::Quiet>(board, movesStart);
 
@@ -313,69 +698,100 @@ INLINE int32_t FixedDepthSearcher::searchAlphaBeta(Move &bestMove, Move hashMove
 
         if (moves.empty() && !hasTacticalMoves) {
             if (isInCheck) { // Checkmate
-                return Score::mateIn(ply);
+                return Score::mateIn(frame->ply);
             } else { // Stalemate
                 return Score::Draw;
             }
         }
 
-        // Futility pruning
-        if (depth == 1 && !isInCheck) {
-            constexpr int32_t FutilityMargin = 300;
-
-            int32_t evaluation = Evaluation::evaluate<Turn>(board, alpha, beta);
-
-            if (evaluation + FutilityMargin <= alpha) {
-                return alpha;
-            }
+        // Futility pruning (the static evaluation was computed in stage 1)
+        if (depth == 1 && !isInCheck && frame->staticEval + SearchParameters::FutilityMargin <= alpha) {
+            return alpha;
         }
 
-        // We already searched the hash move and killer moves, so remove them from the list of moves to search
+        // We already searched the hash move, killer moves and countermove, so remove them from the list of moves to search
         if (hashMove.isValid() && hashMove.isQuiet()) {
             moves.remove(hashMove);
         }
-        for (Move killer : this->heuristics_.killers[depth]) {
-            if (killer.isValid()) {
-                moves.remove(killer);
+        for (Move refutation : refutations) {
+            if (refutation.isValid()) {
+                moves.remove(refutation);
             }
         }
 
-        MoveOrdering::score<Turn, MoveOrdering::Type::Quiet>(moves, board, &this->heuristics_.history);
+        HistoryContext history(this->heuristics_, (frame - 1)->continuation, (frame - 2)->continuation);
+        MoveOrdering::score<Turn, MoveOrdering::Type::Quiet>(moves, board, &history);
 
         // Search all quiet moves
-        uint16_t moveIndex = 0;
-
         while (!moves.empty()) {
             Move move = moves.dequeue();
-            MakeMoveInfo info = board.makeMove<MakeMoveType::AllNoTurn>(move);
 
-            uint16_t depthReduction = 0;
-            if (depth >= 3 && !isInCheck && moveIndex >= 4) {
-                // Late move reduction
-                depthReduction = 1;
+            // Move-level pruning
+            if (!isPvNode && !isInCheck && !Score::isMate(bestScore)) {
+                // Late move pruning
+                if constexpr (SearchParameters::LateMovePruning) {
+                    if (depth <= SearchParameters::LateMovePruningMaxDepth
+                        && frame->searchedQuiets.size() >= SearchParameters::lateMovePruningCount(depth)) {
+                        break;
+                    }
+                }
+
+                // Futility pruning. The margin does not depend on the move, so all remaining quiet moves are futile as well.
+                if constexpr (SearchParameters::QuietFutilityPruning) {
+                    if (depth <= SearchParameters::QuietFutilityMaxDepth
+                        && frame->staticEval + SearchParameters::quietFutilityMargin(depth) <= alpha) {
+                        break;
+                    }
+                }
 
-                if (moveIndex >= 10) {
-                    depthReduction = (depth / 3);
+                // SEE pruning
+                if constexpr (SearchParameters::QuietSeePruning) {
+                    if (depth <= SearchParameters::QuietSeeMaxDepth
+                        && !See::isAtLeast<Turn>(move, board, SearchParameters::quietSeeThreshold(depth))) {
+                        continue;
+                    }
                 }
             }
 
-            int32_t score = -this->search<~Turn>(depth - 1 - depthReduction, ply + 1, -beta, -alpha);
+            // The history score has to be read before the move is made
+            int32_t historyScore = history.quietScore(Turn, board.pieceAt(move.from()).type(), move.to());
+
+            this->setCurrentMove(frame, move);
+            MakeMoveInfo info = board.makeMove<MakeMoveType::AllNoTurn>(move);
+
+            // Late move reduction. The move number counts all moves searched from this node so far, except quiet promotions.
+            uint16_t moveNumber = frame->searchedQuiets.size() + frame->searchedCaptures.size() + 1;
+            int32_t depthReduction = 0;
+            if (depth >= SearchParameters::LmrMinDepth && !isInCheck && moveNumber >= SearchParameters::LmrMinMoveNumber) {
+                depthReduction = lateMoveReduction(depth, moveNumber);
+                depthReduction -= isPvNode;
+                depthReduction -= board.isInCheck<~Turn>();
+                depthReduction -= historyScore / SearchParameters::LmrHistoryDivisor;
+
+                // Never reduce straight into quiescence search, and never extend
+                depthReduction = std::clamp(depthReduction, 0, depth - 2);
+            }
+
+            int32_t score = this->searchMove<Turn>(depth, depthReduction, frame, alpha, beta, !hasSearchedMove);
+            hasSearchedMove = true;
 
             if (score > bestScore) {
                 bestScore = score;
                 bestMove = move;
-                alpha = std::max(alpha, score);
+                if (score > alpha) {
+                    alpha = score;
+                    frame->pv.update(move, (frame + 1)->pv);
+                }
             }
 
             board.unmakeMove<MakeMoveType::AllNoTurn>(move, info);
 
             if (score >= beta) {
-                this->heuristics_.history.add(Turn, board, move, depth);
-                this->heuristics_.killers.add(depth, move);
+                this->updateQuietHeuristics<Turn>(frame, move, depth);
                 return bestScore;
             }
 
-            moveIndex++;
+            frame->searchedQuiets.push(move);
         }
     }
 
@@ -383,7 +799,13 @@ INLINE int32_t FixedDepthSearcher::searchAlphaBeta(Move &bestMove, Move hashMove
 }
 
 template<Color Turn>
-int32_t FixedDepthSearcher::search(uint16_t depth, uint16_t ply, int32_t alpha, int32_t beta) {
+int32_t FixedDepthSearcher::search(uint16_t depth, SearchFrame *frame, int32_t alpha, int32_t beta) {
+    assert(frame->ply <= MaxSearchDepth);
+
+    // Clear the state of the frame left over from previously searched siblings
+    frame->pv.clear();
+    frame->staticEval = Score::None;
+
     if (this->isHalted_) {
         return 0;
     }
@@ -407,7 +829,7 @@ int32_t FixedDepthSearcher::search(uint16_t depth, uint16_t ply, int32_t alpha,
         hashMove = entry->bestMove();
 
         if (entry->depth() >= depth) {
-            this->stats_.incrementTranspositionHits();
+            this->threadStats_.incrementTranspositionHits();
 
             if (entry->flag() == TranspositionTable::Flag::Exact) {
                 return entry->bestScore();
@@ -423,10 +845,17 @@ int32_t FixedDepthSearcher::search(uint16_t depth, uint16_t ply, int32_t alpha,
         }
     }
 
+    // Internal iterative reductions
+    if constexpr (SearchParameters::InternalIterativeReductions) {
+        if (!hashMove.isValid() && depth >= SearchParameters::IirMinDepth) {
+            depth--;
+        }
+    }
+
     int32_t originalAlpha = alpha;
 
     Move bestMove = Move::invalid();
-    int32_t score = this->searchAlphaBeta<Turn>(bestMove, hashMove, depth, ply, alpha, beta);
+    int32_t score = this->searchAlphaBeta<Turn>(bestMove, hashMove, depth, frame, alpha, beta);
 
     // Transposition table store
     if (bestMove.isValid()) {
@@ -4,8 +4,11 @@
 #include <cstdint>
 #include <memory>
 #include <vector>
+#include <chrono>
+#include <atomic>
 
 #include "statistics.h"
+#include "search_stack.h"
 #include "engine/inline.h"
 #include "engine/board/board.h"
 #include "engine/board/color.h"
@@ -32,48 +35,123 @@ struct SearchLine {
     std::vector<Move> moves;
     int32_t score;
 
+    // Whether the search was halted before the iteration was complete, and the line comes from a root move that beat the first
+    // root move that was searched.
+    bool isPartial = false;
+
     SearchLine() = delete;
 
     [[nodiscard]] INLINE bool isValid() const { return !this->moves.empty(); }
 };
 
+// Limits that the searcher checks by itself while searching. As soon as one is reached, the searcher halts (see
+// FixedDepthSearcher::halt). The node limit applies to the node count of the search statistics, so it is shared with any other
+// searchers that use the same statistics.
+struct HaltLimits {
+    std::optional<uint64_t> nodes;
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+};
+
+// A searcher that can be reused for searches of increasing depth on the same position (e.g. for iterative deepening), without
+// having to copy the board or allocate anything between searches.
 class FixedDepthSearcher {
 public:
-    FixedDepthSearcher(const Board &board, uint16_t depth, TranspositionTable &table, HeuristicTables &heuristics,
-        SearchStatistics &stats);
+    // The searcher counts its statistics in the thread statistics with the given index (see SearchStatistics::thread).
+    FixedDepthSearcher(const Board &board, TranspositionTable &table, HeuristicTables &heuristics, SearchStatistics &stats,
+        uint32_t threadIndex = 0);
 
-    [[nodiscard]] SearchLine search();
+    [[nodiscard]] SearchLine search(uint16_t depth);
 
-    // Allows control over the move ordering of the root node.
+    // Allows control over the move ordering of the root node. The moves are searched from the back of the list to the front, and
+    // are not consumed, so the same list can be reordered and searched again at the next depth. The number of nodes searched under
+    // each move and its score are recorded in the list (see RootMoveList::sortByLastIteration).
     // Note: If you want to use the hash move, you must add it to the move list yourself.
-    [[nodiscard]] SearchLine search(RootMoveList moves);
+    [[nodiscard]] SearchLine search(uint16_t depth, RootMoveList &moves);
 
     // Tells the searcher to stop searching as soon as possible. This is not guaranteed to stop the search immediately,
-    // but it will stop the search as soon as possible. Nodes returned from the search will be invalid, and the
-    // transposition table may be corrupted after this function is called.
+    // but it will stop the search as soon as possible. Nodes returned from the search will be invalid (except for a partial
+    // line, see SearchLine::isPartial), and the transposition table may be corrupted after this function is called.
     //
     // Intended to be called from a different thread (otherwise it would be impossible to call this as the search would
     // be blocking the thread).
     void halt();
 
+    // Sets the limits that the searcher halts itself at. They are checked every LimitCheckInterval nodes, so that checking the
+    // clock does not slow down the search. This can be called from a different thread while searching (e.g. to start the clock
+    // when pondering turns into a normal search).
+    void setHaltLimits(const HaltLimits &limits);
+
+    [[nodiscard]] INLINE bool isHalted() const { return this->isHalted_; }
+
+    // The time at which the searcher reached one of its halt limits, if it halted itself. For the deadline, this is the deadline
+    // itself, so that the time it took to notice that the deadline passed is included in the stop latency.
+    [[nodiscard]] INLINE std::optional<std::chrono::steady_clock::time_point> limitReachedAt() const { return this->limitReachedAt_; }
+    [[nodiscard]] INLINE const Board &board() const { return this->board_; }
+
 private:
+    constexpr static uint32_t LimitCheckInterval = 512;
+
     volatile bool isHalted_ = false;
 
+    // The halt limits are atomic since they can be set from another thread. The maximum value means that there is no limit.
+    std::atomic<uint64_t> nodeLimit_ = UINT64_MAX;
+    std::atomic<std::chrono::steady_clock::rep> deadline_ =
+        std::chrono::steady_clock::time_point::max().time_since_epoch().count();
+
+    uint32_t nodesUntilLimitCheck_ = 1;
+    std::optional<std::chrono::steady_clock::time_point> limitReachedAt_;
+
     Board board_;
     uint16_t depth_;
     TranspositionTable &table_;
     HeuristicTables &heuristics_;
     SearchStatistics &stats_;
+    ThreadStatistics &threadStats_;
+    SearchStack stack_;
+
+    // Null move pruning is disabled below this ply while a null move fail-high is being verified, and 0 otherwise.
+    uint16_t nullMoveMinPly_ = 0;
+
+    // Counts a node in the thread's statistics, and checks the halt limits every LimitCheckInterval nodes. The node limit is
+    // checked against the node count of all threads.
+    INLINE void countNode();
+    void checkHaltLimits();
 
+    // Records the move that is about to be made from the frame's ply. Pass an invalid move for null moves.
+    INLINE void setCurrentMove(SearchFrame *frame, Move move);
+
+    // Adds the bonus (or malus, if negative) to the history and continuation history scores of a quiet move.
+    template<Color Turn>
+    INLINE void updateQuietHistories(SearchFrame *frame, Move move, int32_t bonus);
+
+    // Updates the history, killer, countermove and continuation history tables on a beta-cutoff of a quiet move.
+    template<Color Turn>
+    INLINE void updateQuietHeuristics(SearchFrame *frame, Move move, uint16_t depth);
+
+    // Gives a capture history malus to the captures that were searched at the frame's ply, on a beta-cutoff of a later move.
     template<Color Turn>
-    [[nodiscard]] SearchRootNode searchRoot(RootMoveList moves);
+    INLINE void penalizeSearchedCaptures(SearchFrame *frame, int32_t bonus);
 
+    // Updates the capture history on a beta-cutoff of a capture.
+    template<Color Turn>
+    INLINE void updateCaptureHeuristics(SearchFrame *frame, Move move, uint16_t depth);
+
+    template<Color Turn>
+    [[nodiscard]] SearchRootNode searchRoot(RootMoveList &moves);
+
+    template<Color Turn>
+    [[nodiscard]] int32_t searchQuiesce(int32_t alpha, int32_t beta, uint16_t ply);
+    // Searches the move that was just made from the frame's ply with principal variation search (see
+    // https://www.chessprogramming.org/Principal_Variation_Search). The first move of a node is searched with the full window.
+    // Later moves are expected to fail low, so they are searched with a null window (at the reduced depth, if there is a
+    // reduction), and searched again at full depth and then with the full window only while they raise alpha.
     template<Color Turn>
-    [[nodiscard]] int32_t searchQuiesce(int32_t alpha, int32_t beta);
+    [[nodiscard]] INLINE int32_t searchMove(uint16_t depth, uint16_t reduction, SearchFrame *frame, int32_t alpha, int32_t beta,
+        bool isFirstMove);
     template<Color Turn>
-    [[nodiscard]] int32_t searchAlphaBeta(Move &bestMove, Move hashMove, uint16_t depth, uint16_t ply, int32_t &alpha, int32_t beta);
+    [[nodiscard]] int32_t searchAlphaBeta(Move &bestMove, Move hashMove, uint16_t depth, SearchFrame *frame, int32_t &alpha, int32_t beta);
     template<Color Turn>
-    [[nodiscard]] int32_t search(uint16_t depth, uint16_t ply, int32_t alpha, int32_t beta);
+    [[nodiscard]] int32_t search(uint16_t depth, SearchFrame *frame, int32_t alpha, int32_t beta);
 };
 
 } // namespace FKTB
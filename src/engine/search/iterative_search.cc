@@ -6,7 +6,9 @@
 #include <algorithm>
 #include <random>
 #include <condition_variable>
+#include <utility>
 #include <cassert>
+#include <chrono>
 
 #include "fixed_search.h"
 #include "statistics.h"
@@ -15,49 +17,79 @@
 
 namespace FKTB {
 
-SearchResult::SearchResult() : depth(0), bestLine(), score(0), nodeCount(0), transpositionHits(0), elapsed() { }
+SearchResult::SearchResult() : depth(0), bestLine(), score(0), nodeCount(0), selectiveDepth(0), transpositionHits(0), elapsed(),
+                               bestMoveNodeFraction(0.0), isPartial(false), stopLatency(0) { }
 
-SearchResult::SearchResult(uint16_t depth, SearchLine line, const SearchStatistics &stats) : elapsed() {
+SearchResult::SearchResult(uint16_t depth, SearchLine line, double bestMoveNodeFraction, const SearchStatistics &stats)
+    : elapsed(), stopLatency(0) {
     this->depth = depth;
     this->bestLine = std::move(line.moves);
     this->score = line.score;
     this->nodeCount = stats.nodeCount();
+    this->selectiveDepth = stats.selectiveDepth();
     this->transpositionHits = stats.transpositionHits();
     this->elapsed = stats.elapsed();
+    this->bestMoveNodeFraction = bestMoveNodeFraction;
+    this->isPartial = line.isPartial;
 }
 
 
 
+// Everything that a search thread needs for one iterative deepening search. The searcher and root move list live for the entire
+// search, so that nothing needs to be copied or allocated between iterations.
 struct SearchTask {
-    Board board;
     uint16_t depth = 1;
-    std::optional<RootMoveList> rootMoveOrder = std::nullopt;
+    RootMoveList rootMoves;
     bool canUseHashMove = false;
     TranspositionTable &table;
-    HeuristicTables heuristics;
     SearchStatistics &stats;
-    std::unique_ptr<FixedDepthSearcher> iteration = nullptr;
+    FixedDepthSearcher searcher;
 
-    SearchTask(const Board &board, TranspositionTable &table, SearchStatistics &stats) : board(board.copy()), table(table),
-                                                                                         heuristics(), stats(stats) { }
+    SearchTask(const Board &board, RootMoveList rootMoves, TranspositionTable &table, HeuristicTables &heuristics,
+        SearchStatistics &stats, uint32_t threadIndex) : rootMoves(std::move(rootMoves)), table(table), stats(stats),
+                                                         searcher(board, table, heuristics, stats, threadIndex) { }
+
+    // Whether there is nothing left to search until the search is stopped, either because the maximum depth was searched, or
+    // because the searcher was halted by one of the search limits.
+    [[nodiscard]] INLINE bool isFinished() const { return this->depth > MaxSearchDepth || this->searcher.isHalted(); }
 };
 
 
 
-// TODO: Add a destructor to properly kill the thread
+// A worker of the search thread pool. The thread waits on a condition variable while it has no task, and is joined when the
+// SearchThread is destroyed.
 class IterativeSearcher::SearchThread {
 public:
     explicit SearchThread(IterativeSearcher &manager);
 
+    // Must not be called while searching.
+    ~SearchThread();
+
     // Starts an iterative deepening search beginning from the given depth and root node move order.
     void start(std::unique_ptr<SearchTask> task);
-    void stop();
+
+    // Stops the search, and returns the result of the partially completed iteration if there is one (otherwise an invalid result).
+    SearchResult stop();
+
+    // Makes the search finish without starting another iteration, e.g. because the depth limit was reached. Unlike stop(), this
+    // does not wait for anything, so it can be called from the search thread itself.
+    void finish();
+
+    // Sets the halt limits of the searcher, while it may be searching.
+    void setHaltLimits(const HaltLimits &limits);
 
     [[nodiscard]] INLINE bool isSearching() const { return this->task_ != nullptr; }
+    [[nodiscard]] bool isFinished() const;
+
+    // The heuristic tables are kept between searches, so that move ordering does not have to be learned from scratch every move.
+    // They are aged at the start of each search.
+    [[nodiscard]] INLINE HeuristicTables &heuristics() { return this->heuristics_; }
 
 private:
     IterativeSearcher &manager_;
 
+    HeuristicTables heuristics_;
+
     std::thread thread_;
 
     // Task mutex is used for synchronizing access to task_.
@@ -78,19 +110,38 @@ private:
     // the search was stopped immediately before you could lock the task mutex.
     std::unique_ptr<SearchTask> task_;
 
-    void awaitTask();
+    // Set when the SearchThread is destroyed, to make the thread return from loop(). Only accessed with the task mutex locked.
+    bool isExiting_;
+
+    // The result of an iteration that was halted (by SearchThread::stop() or by one of the search limits), but still found a
+    // better move than the previous iteration. Only accessed with the search mutex locked.
+    SearchResult partialResult_;
+
+    // Waits until there is a task, and returns true, or until the thread should exit, and returns false.
+    bool awaitTask();
     SearchResult searchIteration();
 
-    [[noreturn]] void loop();
+    void loop();
 };
 
 
 
-IterativeSearcher::SearchThread::SearchThread(IterativeSearcher &manager) : manager_(manager), taskMutex_(),
+IterativeSearcher::SearchThread::SearchThread(IterativeSearcher &manager) : manager_(manager), heuristics_(), taskMutex_(),
                                                                             searchMutex_(), isSearchingCondition_(),
-                                                                            task_(nullptr) {
+                                                                            task_(nullptr), isExiting_(false), partialResult_() {
     this->thread_ = std::thread(&SearchThread::loop, this);
-    this->thread_.detach();
+}
+
+IterativeSearcher::SearchThread::~SearchThread() {
+    {
+        std::lock_guard taskLock(this->taskMutex_);
+        assert(!this->isSearching() && "SearchThread must not be destroyed while searching");
+
+        this->isExiting_ = true;
+    }
+
+    this->isSearchingCondition_.notify_all();
+    this->thread_.join();
 }
 
 // Starts an iterative deepening search beginning from the given depth and root node move order.
@@ -106,12 +157,15 @@ void IterativeSearcher::SearchThread::start(std::unique_ptr<SearchTask> task) {
         throw std::runtime_error("Already searching");
     }
 
+    // The search thread is not using the heuristic tables, since it is not searching.
+    this->heuristics_.age();
+
     this->task_ = std::move(task);
 
     this->isSearchingCondition_.notify_all();
 }
 
-void IterativeSearcher::SearchThread::stop() {
+SearchResult IterativeSearcher::SearchThread::stop() {
     assert(this->manager_.mutex_.locked_by_caller() && "SearchThread::stop() must be called with the manager's mutex locked");
     assert(!this->taskMutex_.locked_by_caller() && "SearchThread::stop() must not be called with the task mutex locked");
     assert(!this->searchMutex_.locked_by_caller() && "SearchThread::stop() must not be called with the search mutex locked");
@@ -122,42 +176,67 @@ void IterativeSearcher::SearchThread::stop() {
         throw std::runtime_error("Not searching");
     }
 
+    // If the search already finished by itself, its stop latency was measured when it halted.
+    bool wasRunning = !this->task_->isFinished();
+    auto haltedAt = std::chrono::steady_clock::now();
+
     // Stop the current search
-    //
-    // this->task_->iteration can be nullptr if the search was stopped before the first iteration was started (i.e. the user
-    // immediately stopped the search after starting it)
-    if (this->task_->iteration != nullptr) {
-        this->task_->iteration->halt();
-    }
+    this->task_->searcher.halt();
 
     // Wait for the search to stop by waiting for the search mutex to be released (will be released when the searcher
     // is done)
     std::lock_guard searchLock(this->searchMutex_);
 
+    if (wasRunning) {
+        this->task_->stats.recordStopLatency(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - haltedAt));
+    }
+
     this->task_ = nullptr;
-}
 
+    // Wake up the search thread if the search finished and it is waiting to be stopped.
+    this->isSearchingCondition_.notify_all();
 
+    return std::exchange(this->partialResult_, SearchResult::invalid());
+}
 
-void IterativeSearcher::SearchThread::awaitTask() {
-    assert(!this->taskMutex_.locked_by_caller() && "SearchThread::awaitTask() must not be called with the task mutex locked");
+void IterativeSearcher::SearchThread::finish() {
+    assert(this->manager_.mutex_.locked_by_caller() && "SearchThread::finish() must be called with the manager's mutex locked");
 
-    // Check if we already have a task
-    bool hasTask;
-    {
-        std::lock_guard taskLock(this->taskMutex_);
-        hasTask = (this->task_ != nullptr);
+    // The task mutex is not needed (and may already be locked by this thread if it is reporting a result), since the task can only
+    // be replaced or destroyed with the manager's mutex locked.
+    if (this->task_ != nullptr) {
+        this->task_->searcher.halt();
     }
+}
 
-    if (hasTask) {
-        return;
+void IterativeSearcher::SearchThread::setHaltLimits(const HaltLimits &limits) {
+    assert(this->manager_.mutex_.locked_by_caller() && "SearchThread::setHaltLimits() must be called with the manager's mutex locked");
+
+    if (this->task_ != nullptr) {
+        this->task_->searcher.setHaltLimits(limits);
     }
+}
+
+bool IterativeSearcher::SearchThread::isFinished() const {
+    assert(this->manager_.mutex_.locked_by_caller() && "SearchThread::isFinished() must be called with the manager's mutex locked");
+
+    // Like in finish(), the task mutex is not needed, so this can be called by any search thread while it is reporting a result.
+    return this->task_ != nullptr && this->task_->isFinished();
+}
+
+
+
+bool IterativeSearcher::SearchThread::awaitTask() {
+    assert(!this->taskMutex_.locked_by_caller() && "SearchThread::awaitTask() must not be called with the task mutex locked");
 
-    // Wait for a task to be assigned
+    // Wait for a task to be assigned (returns immediately if we already have one)
     std::unique_lock<ami::mutex> taskLock(this->taskMutex_);
     this->isSearchingCondition_.wait(taskLock, [this]() {
-        return this->isSearching();
+        return this->isSearching() || this->isExiting_;
     });
+
+    return !this->isExiting_;
 }
 
 SearchResult IterativeSearcher::SearchThread::searchIteration() {
@@ -168,20 +247,21 @@ SearchResult IterativeSearcher::SearchThread::searchIteration() {
 
     std::optional<std::lock_guard<ami::mutex>> searchLock;
 
-    // Create a copy of parts of the task that we need, so that we are not holding the task mutex while searching.
-    // Also create the FixedDepthSearcher here.
     uint16_t depth;
-    SearchStatistics *stats;
-    std::optional<RootMoveList> rootMoveOrder;
-    FixedDepthSearcher *iteration;
+    SearchTask *task;
 
     {
-        std::lock_guard taskLock(this->taskMutex_);
+        std::unique_lock taskLock(this->taskMutex_);
 
-        // The search mutex must be locked here before we create the searcher, because we have to prevent SearchThread::stop()
-        // from destroying this->task_. If we were to instead lock the search mutex after creating the searcher but before we
-        // search, then it is possible that SearchThread::stop() can acquire the search mutex before we do, and destroy
-        // this->task_. The searcher stores references to parts of this->task_, so it cannot be destroyed while we are searching.
+        // If the search already finished, there is nothing left to do until the search is stopped.
+        this->isSearchingCondition_.wait(taskLock, [this]() {
+            return this->task_ == nullptr || !this->task_->isFinished();
+        });
+
+        // The search mutex must be locked here, while the task mutex is still locked, because we have to prevent
+        // SearchThread::stop() from destroying this->task_. If we were to instead lock the search mutex after releasing the task
+        // mutex, then it is possible that SearchThread::stop() can acquire the search mutex before we do, and destroy this->task_
+        // while we are searching it.
         searchLock.emplace(this->searchMutex_);
 
         // Check if the search was stopped immediately before we could lock the task mutex
@@ -189,35 +269,45 @@ SearchResult IterativeSearcher::SearchThread::searchIteration() {
             return SearchResult::invalid();
         }
 
-        SearchTask &task = *this->task_;
+        task = this->task_.get();
+        depth = task->depth;
+    }
 
-        depth = task.depth;
-        stats = &task.stats;
+    // Between iterations, only the root move order changes. After the hash move (which is the best move of the last iteration),
+    // the moves that raised alpha in the last iteration are searched first, then the ones that needed the most nodes to refute.
+    if (task->canUseHashMove) {
+        task->rootMoves.sortByLastIteration();
+        task->rootMoves.loadHashMove(task->searcher.board(), task->table);
+    }
 
-        rootMoveOrder = task.rootMoveOrder;
-        if (task.canUseHashMove) {
-            // Load the hash move
-            rootMoveOrder->loadHashMove(task.board, task.table);
-        }
+    // Search
+    SearchLine line = task->searcher.search(depth, task->rootMoves);
 
-        // Create a new searcher
-        task.iteration = std::make_unique<FixedDepthSearcher>(task.board, task.depth, task.table, task.heuristics, task.stats);
+    // If the searcher halted itself, measure how long it took to stop after reaching the limit
+    std::optional<std::chrono::steady_clock::time_point> limitReachedAt = task->searcher.limitReachedAt();
+    if (limitReachedAt.has_value()) {
+        task->stats.recordStopLatency(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - limitReachedAt.value()));
+    }
 
-        iteration = task.iteration.get();
+    double bestMoveNodeFraction = line.isValid() ? task->rootMoves.nodeFraction(line.moves[0]) : 0.0;
+    SearchResult result(depth, std::move(line), bestMoveNodeFraction, task->stats);
+
+    // Whatever halted the search, SearchThread::stop() takes the partial result once we release the search mutex.
+    if (result.isPartial) {
+        this->partialResult_ = std::move(result);
+        return SearchResult::invalid();
     }
 
-    // Search
-    SearchLine line = iteration->search(rootMoveOrder.value());
-    return { depth, std::move(line), *stats };
+    return result;
 }
 
-[[noreturn]] void IterativeSearcher::SearchThread::loop() {
-    while (true) {
-        this->awaitTask();
-
+void IterativeSearcher::SearchThread::loop() {
+    while (this->awaitTask()) {
         SearchResult result = this->searchIteration();
 
-        if (result.isValid()) {
+        bool shouldNotifyFinish;
+        {
             std::lock_guard managerLock(this->manager_.mutex_);
             std::lock_guard taskLock(this->taskMutex_);
 
@@ -226,34 +316,84 @@ SearchResult IterativeSearcher::SearchThread::searchIteration() {
                 continue;
             }
 
-            // Increment depth
+            // Increment depth (even if there is no result, e.g. if there are no legal moves, since searching the same depth again
+            // would not give a different result)
             this->task_->depth++;
 
             // Notify manager that we have a result
-            this->manager_.receiveResultFromThread(result);
+            if (result.isValid()) {
+                this->manager_.receiveResultFromThread(result, this == this->manager_.threads_.front().get());
+            }
+
+            shouldNotifyFinish = this->manager_.takeFinishNotification();
+        }
+
+        // The finish callbacks are expected to stop the search, so they must be called without any locks held.
+        if (shouldNotifyFinish) {
+            this->manager_.notifyFinishCallbacks();
         }
     }
 }
 
 
 
-IterativeSearcher::IterativeSearcher(uint32_t threadCount) : threads_(), mutex_(), callbacks_(), result_(SearchResult::invalid()),
+IterativeSearcher::IterativeSearcher(uint32_t threadCount) : threads_(), mutex_(), callbacks_(), finishCallbacks_(), limits_(),
+                                                             result_(SearchResult::invalid()), hasNotifiedFinish_(false),
                                                              table_(4194304), stats_() {
-    // Lazy SMP seems to be broken atm so only allow one thread
-    assert(threadCount == 1);
+    this->setThreadCount(threadCount);
+}
+
+IterativeSearcher::~IterativeSearcher() {
+    if (this->isSearching()) {
+        (void) this->stop();
+    }
 
-    this->threads_.reserve(threadCount);
-    for (uint32_t i = 0; i < threadCount; i++) {
+    // The threads must be joined before the rest of the members are destroyed, since they use the manager's mutex
+    this->threads_.clear();
+}
+
+void IterativeSearcher::setThreadCount(uint32_t threadCount) {
+    assert(
+        !this->mutex_.locked_by_caller() && "IterativeSearcher::setThreadCount() must not be called with the manager's mutex locked");
+    assert(threadCount >= 1);
+
+    std::lock_guard managerLock(this->mutex_);
+
+    for (const auto &thread : this->threads_) {
+        if (thread->isSearching()) {
+            throw std::runtime_error("Cannot change the thread count while searching");
+        }
+    }
+
+    // Removed threads are joined by their destructors
+    while (this->threads_.size() > threadCount) {
+        this->threads_.pop_back();
+    }
+    while (this->threads_.size() < threadCount) {
         this->threads_.push_back(std::make_unique<SearchThread>(*this));
     }
+
+    this->stats_.resize(threadCount);
 }
 
-IterativeSearcher::~IterativeSearcher() = default;
+bool IterativeSearcher::isSearching() {
+    assert(
+        !this->mutex_.locked_by_caller() && "IterativeSearcher::isSearching() must not be called with the manager's mutex locked");
+
+    std::lock_guard managerLock(this->mutex_);
+
+    // Tasks are only assigned and removed with the manager's mutex locked, and always to all threads at once
+    return this->threads_.front()->isSearching();
+}
 
 void IterativeSearcher::addIterationCallback(IterationCallback callback) {
     this->callbacks_.push_back(std::move(callback));
 }
 
+void IterativeSearcher::addFinishCallback(FinishCallback callback) {
+    this->finishCallbacks_.push_back(std::move(callback));
+}
+
 void IterativeSearcher::notifyCallbacks(const SearchResult &result) {
     assert(
         this->mutex_.locked_by_caller() && "IterativeSearcher::notifyCallbacks() must be called with the manager's mutex locked");
@@ -263,7 +403,29 @@ void IterativeSearcher::notifyCallbacks(const SearchResult &result) {
     }
 }
 
-void IterativeSearcher::receiveResultFromThread(const SearchResult &result) {
+void IterativeSearcher::notifyFinishCallbacks() {
+    assert(!this->mutex_.locked_by_caller()
+        && "IterativeSearcher::notifyFinishCallbacks() must not be called with the manager's mutex locked");
+
+    for (const auto &callback : this->finishCallbacks_) {
+        callback();
+    }
+}
+
+bool IterativeSearcher::takeFinishNotification() {
+    assert(this->mutex_.locked_by_caller()
+        && "IterativeSearcher::takeFinishNotification() must be called with the manager's mutex locked");
+
+    // Like in isFinished(), only the primary thread counts
+    if (this->hasNotifiedFinish_ || !this->threads_.front()->isFinished()) {
+        return false;
+    }
+
+    this->hasNotifiedFinish_ = true;
+    return true;
+}
+
+void IterativeSearcher::receiveResultFromThread(const SearchResult &result, bool isPrimary) {
     assert(
         this->mutex_.locked_by_caller() && "IterativeSearcher::receiveResultFromThread() must be called with the manager's mutex locked");
 
@@ -271,14 +433,29 @@ void IterativeSearcher::receiveResultFromThread(const SearchResult &result) {
         return;
     }
 
+    if (isPrimary && this->limits_.timeManager.has_value()) {
+        this->limits_.timeManager->recordPrimaryIteration();
+    }
+
     // Check if the result is deeper than the current result
     if (!this->result_.isValid() || result.depth > this->result_.depth) {
         this->result_ = result;
         this->notifyCallbacks(result);
+
+        // Finish between iterations if the depth limit was reached, or if the time manager decides that another iteration is not
+        // worth starting.
+        bool reachedDepthLimit = this->limits_.depth.has_value() && result.depth >= this->limits_.depth.value();
+        bool outOfTime = this->limits_.timeManager.has_value() && this->limits_.timeManager->shouldStop(result);
+
+        if (reachedDepthLimit || outOfTime) {
+            for (const auto &thread : this->threads_) {
+                thread->finish();
+            }
+        }
     }
 }
 
-void IterativeSearcher::start(const Board &board) {
+void IterativeSearcher::start(const Board &board, SearchLimits limits) {
     assert(!this->mutex_.locked_by_caller() && "IterativeSearcher::start() must not be called with the manager's mutex locked");
 
     std::lock_guard managerLock(this->mutex_);
@@ -286,6 +463,10 @@ void IterativeSearcher::start(const Board &board) {
     this->result_ = SearchResult::invalid();
     this->table_.clear();
     this->stats_.reset();
+    this->limits_ = std::move(limits);
+    this->hasNotifiedFinish_ = false;
+
+    HaltLimits haltLimits = this->haltLimits();
 
     Board boardCopy = board.copy();
     RootMoveList rootMoves = MoveGeneration::generateLegalRoot(boardCopy);
@@ -294,10 +475,10 @@ void IterativeSearcher::start(const Board &board) {
     std::mt19937 generator(device());
 
     for (uint32_t i = 0; i < this->threads_.size(); i++) {
-        std::unique_ptr<SearchTask> task = std::make_unique<SearchTask>(board, this->table_, this->stats_);
-
         // Create a copy of the root moves so that we can modify it
         RootMoveList rootMoveOrder = rootMoves;
+        uint16_t depth;
+        bool canUseHashMove;
 
         if (i == 0) {
             // First thread is our "primary" thread, so it should not randomize anything and should use the hash move.
@@ -306,22 +487,22 @@ void IterativeSearcher::start(const Board &board) {
             MoveOrdering::score<MoveOrdering::Type::AllNoHistory>(rootMoveOrder, boardCopy, nullptr);
             rootMoveOrder.sort();
 
-            task->depth = 1;
+            depth = 1;
 
             // Only permit the first thread to use the hash move, since otherwise, multiple threads will be searching
             // the hash move at the same time, leading to lots of wasted search time (lots of time will be wasted since they are
             // all searching the same tree).
-            task->canUseHashMove = true;
+            canUseHashMove = true;
         } else {
             // Other threads are helper threads, so they should randomize the root move order and start at a higher
             // depth.
 
             // Start at a higher depth for other threads.
-            task->depth = (i / 2) + 5;
-            task->canUseHashMove = false;
+            depth = (i / 2) + 5;
+            canUseHashMove = false;
             if ((i % 7) == 0) {
                 // Have every seventh thread have an insanely high depth just for fun
-                task->depth = (i * 3) + 5;
+                depth = (i * 3) + 5;
             }
 
             // Move ordering
@@ -336,7 +517,7 @@ void IterativeSearcher::start(const Board &board) {
                 // Add a small random value to the score of each move
                 int32_t range = (25 * static_cast<int32_t>(i));
                 std::uniform_int_distribution<int32_t> distribution(-range, range);
-                for (MoveEntry &entry : rootMoveOrder.moves()) {
+                for (RootMoveEntry &entry : rootMoveOrder.moves()) {
                     entry.score += distribution(generator);
                 }
 
@@ -344,9 +525,35 @@ void IterativeSearcher::start(const Board &board) {
             }
         }
 
-        task->rootMoveOrder = std::move(rootMoveOrder);
+        SearchThread &thread = *this->threads_[i];
+
+        auto task = std::make_unique<SearchTask>(board, std::move(rootMoveOrder), this->table_, thread.heuristics(), this->stats_,
+            i);
+        task->depth = std::min(depth, MaxSearchDepth);
+        task->canUseHashMove = canUseHashMove;
+        task->searcher.setHaltLimits(haltLimits);
+
+        thread.start(std::move(task));
+    }
+}
+
+void IterativeSearcher::setLimits(SearchLimits limits) {
+    assert(!this->mutex_.locked_by_caller() && "IterativeSearcher::setLimits() must not be called with the manager's mutex locked");
+
+    std::lock_guard managerLock(this->mutex_);
+
+    this->limits_ = std::move(limits);
+
+    HaltLimits haltLimits = this->haltLimits();
+    for (const auto &thread : this->threads_) {
+        thread->setHaltLimits(haltLimits);
+    }
 
-        this->threads_[i]->start(std::move(task));
+    // The depth limit may have been reached already
+    if (this->result_.isValid() && this->limits_.depth.has_value() && this->result_.depth >= this->limits_.depth.value()) {
+        for (const auto &thread : this->threads_) {
+            thread->finish();
+        }
     }
 }
 
@@ -355,17 +562,55 @@ SearchResult IterativeSearcher::stop() {
 
     std::lock_guard managerLock(this->mutex_);
 
-    for (const auto &thread : this->threads_) {
-        thread->stop();
+    for (uint32_t i = 0; i < this->threads_.size(); i++) {
+        SearchResult partialResult = this->threads_[i]->stop();
+
+        // Only the primary thread searches the previous iteration's best move first. The helper threads search their root moves in
+        // a random order, so their partial best move only beat a random move and is discarded.
+        if (i != 0) {
+            continue;
+        }
+
+        if (partialResult.isValid() && (!this->result_.isValid() || partialResult.depth > this->result_.depth)) {
+            this->result_ = std::move(partialResult);
+        }
     }
 
     SearchResult result = std::move(this->result_);
+    result.stopLatency = this->stats_.stopLatency();
 
     this->result_ = SearchResult::invalid();
+    this->limits_ = { };
     this->table_.clear();
     this->stats_.reset();
 
     return result;
 }
 
+HaltLimits IterativeSearcher::haltLimits() const {
+    // The time limit is the sooner of the fixed time limit and the time manager's hard limit
+    std::optional<std::chrono::milliseconds> timeLimit = this->limits_.time;
+    if (this->limits_.timeManager.has_value()) {
+        std::chrono::milliseconds hardLimit = this->limits_.timeManager->hardLimit();
+        timeLimit = timeLimit.has_value() ? std::min(timeLimit.value(), hardLimit) : hardLimit;
+    }
+
+    HaltLimits limits;
+    limits.nodes = this->limits_.nodes;
+    if (timeLimit.has_value()) {
+        limits.deadline = std::chrono::steady_clock::now() + timeLimit.value();
+    }
+
+    return limits;
+}
+
+bool IterativeSearcher::isFinished() {
+    assert(!this->mutex_.locked_by_caller() && "IterativeSearcher::isFinished() must not be called with the manager's mutex locked");
+
+    std::lock_guard managerLock(this->mutex_);
+
+    // The helper threads only help the primary thread, so the search is finished once the primary thread is
+    return this->threads_.front()->isFinished();
+}
+
 } // namespace FKTB
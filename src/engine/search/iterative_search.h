@@ -4,10 +4,12 @@
 #include <memory>
 #include <vector>
 #include <chrono>
+#include <optional>
 #include <functional>
 
 #include "statistics.h"
 #include "fixed_search.h"
+#include "time_manager.h"
 #include "engine/inline.h"
 #include "engine/mutex.h"
 #include "engine/board/piece.h"
@@ -24,27 +26,75 @@ struct SearchResult {
     std::vector<Move> bestLine;
     int32_t score;
     uint64_t nodeCount;
+    uint16_t selectiveDepth;
     uint64_t transpositionHits;
     std::chrono::milliseconds elapsed;
 
+    // The fraction of the nodes of the iteration that were spent searching the best move. If it is high, the best move is unlikely
+    // to change with more time.
+    double bestMoveNodeFraction;
+
+    // Whether the result comes from an iteration that was stopped before it was complete (see SearchLine::isPartial).
+    bool isPartial;
+
+    // How long it took the search to stop after it was halted. Only set in the result returned by IterativeSearcher::stop().
+    std::chrono::microseconds stopLatency;
+
     SearchResult(); // Creates an invalid search result.
-    SearchResult(uint16_t depth, SearchLine line, const SearchStatistics &statistics);
+    SearchResult(uint16_t depth, SearchLine line, double bestMoveNodeFraction, const SearchStatistics &statistics);
 
     [[nodiscard]] INLINE bool isValid() const { return !this->bestLine.empty(); }
 };
 
+// Limits of an iterative search. The node and time limits are checked by the search threads while searching, the depth limit and
+// the time manager are checked between iterations. Once any limit is reached, the search finishes by itself (see FinishCallback).
+struct SearchLimits {
+    std::optional<uint16_t> depth;
+    std::optional<uint64_t> nodes;
+    std::optional<std::chrono::milliseconds> time;
+
+    // When searching with a clock. Its hard limit is added to the time limit.
+    std::optional<TimeManager> timeManager;
+};
+
 using IterationCallback = std::function<void(const SearchResult &result)>;
 
+// Called once per search from a search thread, without any locks held, when the search finished by itself because it reached one
+// of its limits (or the maximum search depth). The search is still considered to be running until IterativeSearcher::stop() is
+// called, which returns the result. Callbacks must check IterativeSearcher::isFinished() after synchronizing, since the search may
+// have been stopped and another one started in the meantime.
+using FinishCallback = std::function<void()>;
+
 class IterativeSearcher {
 public:
     explicit IterativeSearcher(uint32_t threadCount);
+
+    // Stops the search if there is one, and joins all search threads.
     ~IterativeSearcher();
 
+    // Resizes the search thread pool, creating or joining threads as needed. Must not be called while searching.
+    void setThreadCount(uint32_t threadCount);
+
+    [[nodiscard]] INLINE uint32_t threadCount() const { return this->threads_.size(); }
+
     void addIterationCallback(IterationCallback callback);
+    void addFinishCallback(FinishCallback callback);
+
+    void start(const Board &board, SearchLimits limits = { });
+
+    // Replaces the limits of a running search, without losing anything that was searched so far. The time limits start counting
+    // from now. This is used to turn a ponder search (which has no limits) into a normal search on a ponder hit.
+    void setLimits(SearchLimits limits);
 
-    void start(const Board &board);
+    // Stops the search and returns the deepest result. This may be a partial result from the iteration that the primary thread was
+    // searching, which is not passed to the iteration callbacks.
     SearchResult stop();
 
+    [[nodiscard]] bool isSearching();
+
+    // Returns true if the search finished by itself and is waiting to be stopped.
+    [[nodiscard]] bool isFinished();
+
     [[nodiscard]] INLINE const SearchStatistics &stats() const { return this->stats_; }
 
 private:
@@ -54,12 +104,27 @@ private:
     ami::mutex mutex_;
 
     std::vector<IterationCallback> callbacks_;
+    std::vector<FinishCallback> finishCallbacks_;
+    SearchLimits limits_;
     SearchResult result_;
+
+    // Set once a search thread took it upon itself to call the finish callbacks, so that they are only called once per search,
+    // even though every search thread sees the search finish.
+    bool hasNotifiedFinish_;
+
     TranspositionTable table_;
     SearchStatistics stats_;
 
+    // Returns the halt limits of the search threads, for limits_ starting from now.
+    [[nodiscard]] HaltLimits haltLimits() const;
+
     void notifyCallbacks(const SearchResult &result);
-    void receiveResultFromThread(const SearchResult &result);
+    void notifyFinishCallbacks();
+
+    // Returns true if the search finished and the finish callbacks were not called yet, in which case the caller must call them.
+    [[nodiscard]] bool takeFinishNotification();
+    // isPrimary is true if the result comes from the primary thread (the first thread).
+    void receiveResultFromThread(const SearchResult &result, bool isPrimary);
 };
 
 } // namespace FKTB
@@ -1,60 +1,63 @@
 #include "heuristics.h"
 
-#include <cstdlib>
-#include <cstring>
-
 namespace FKTB {
 
-HistoryTable::HistoryTable() : table_() { }
+namespace {
+
+// Calls the function on every entry of a table indexed by color, piece type and square.
+template<typename T, typename Function>
+INLINE void forEachEntry(ColorMap<PieceTypeMap<SquareMap<T>>> &table, Function function) {
+    for (Color color : { Color::White, Color::Black }) {
+        for (PieceType type = PieceType::Pawn; type <= PieceType::King; type = static_cast<PieceType>(type + 1)) {
+            for (T &entry : table[color][type]) {
+                function(entry);
+            }
+        }
+    }
+}
 
+} // namespace
 
 
-KillerTable::KillerTable() {
-    this->size_ = 0;
-    this->table_ = nullptr;
-}
 
-KillerTable::~KillerTable() {
-    std::free(this->table_);
+HistoryTable::HistoryTable() : table_() { }
+
+void HistoryTable::age() {
+    forEachEntry(this->table_, [](int32_t &score) { score /= 2; });
 }
 
-void KillerTable::resize(uint16_t size) {
-    assert(size > this->size_);
 
-    auto newTable = static_cast<KillerTable::Ply *>(std::calloc(size, sizeof(KillerTable::Ply)));
 
-    // Keep the old moves anchored to the end of the table and add new space to the front. This keeps the depth indices consistent
-    // between resizes.
-    std::memcpy(newTable + size - this->size_, this->table_, this->size_ * sizeof(KillerTable::Ply));
+CountermoveTable::CountermoveTable() : table_() { }
 
-    std::free(this->table_);
-    this->size_ = size;
-    this->table_ = newTable;
-}
 
-void KillerTable::add(uint16_t depth, Move move) {
-    assert(depth < this->size_);
 
-    auto &killers = this->table_[depth];
+ContinuationHistory::ContinuationHistory() : table_(std::make_unique<ColorMap<PieceTypeMap<SquareMap<HistoryTable>>>>()) { }
+
+void ContinuationHistory::age() {
+    forEachEntry(*this->table_, [](HistoryTable &history) { history.age(); });
+}
 
-    // Check if the move is already in the table.
-    for (auto &killer : killers) {
-        if (killer == move) {
-            return;
-        }
-    }
 
-    // Shift the moves down.
-    for (uint8_t i = 0; i < KillerTable::MaxKillerMoves - 1; i++) {
-        killers[i + 1] = killers[i];
-    }
 
-    // Insert the new move.
-    killers[0] = move;
+CaptureHistory::CaptureHistory() : table_() { }
+
+void CaptureHistory::age() {
+    forEachEntry(this->table_, [](PieceTypeMap<int32_t> &captured) {
+        for (PieceType type = PieceType::Pawn; type <= PieceType::Queen; type = static_cast<PieceType>(type + 1)) {
+            captured[type] /= 2;
+        }
+    });
 }
 
 
 
-HeuristicTables::HeuristicTables() : history(), killers() { }
+HeuristicTables::HeuristicTables() : history(), countermoves(), continuations(), captures() { }
+
+void HeuristicTables::age() {
+    this->history.age();
+    this->continuations.age();
+    this->captures.age();
+}
 
 } // namespace FKTB
@@ -1,6 +1,11 @@
 #pragma once
 
 #include <cstdint>
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+#include <array>
+#include <memory>
 
 #include "engine/inline.h"
 #include "engine/move/move.h"
@@ -14,70 +19,215 @@ namespace FKTB {
 
 class HistoryTable {
 public:
+    // History scores are always within [-MaxScore, MaxScore].
+    constexpr static int32_t MaxScore = 16384;
+
     HistoryTable();
 
-    // Increments the history table. Call this on beta-cutoffs of quiet moves.
-    INLINE void add(Color color, const Board &board, Move move, uint16_t depth);
+    // Returns the history bonus for a beta-cutoff at the given depth. Use the negated bonus as a malus for quiet moves that were
+    // searched before the move that caused the cutoff.
+    [[nodiscard]] INLINE constexpr static int32_t bonus(uint16_t depth);
+
+    // Updates the history score of the given move with a bonus (or malus, if negative). Must be called when the move is not made.
+    //
+    // Uses the "gravity" formula, which scales the update down the closer the score already is to the bound in the same
+    // direction. This keeps the scores bounded and lets scores that have become stale be overwritten quickly.
+    INLINE void update(Color color, const Board &board, Move move, int32_t bonus);
 
-    // Returns the history score for the given move. The returned score is normalized based off of the total sum of all history
-    // scores so that at higher depths, the history scores aren't insanely high compared to at lower depths.
+    // Applies the gravity formula to a single score. Shared with the other history tables.
+    INLINE static void applyBonus(int32_t &score, int32_t bonus);
+
+    // Returns the history score for the given move.
     [[nodiscard]] INLINE int32_t score(Color color, PieceType type, Square to) const;
 
+    // Halves all history scores. Called between searches, so that old searches (or games) still help move ordering, but do not
+    // dominate the scores of the current search.
+    void age();
+
+private:
+    ColorMap<PieceTypeMap<SquareMap<int32_t>>> table_;
+};
+
+INLINE constexpr int32_t HistoryTable::bonus(uint16_t depth) {
+    constexpr int32_t MaxBonus = 2048;
+    return std::min(128 * depth * depth, MaxBonus);
+}
+
+INLINE void HistoryTable::update(Color color, const Board &board, Move move, int32_t bonus) {
+    HistoryTable::applyBonus(this->table_[color][board.pieceAt(move.from()).type()][move.to()], bonus);
+}
+
+INLINE void HistoryTable::applyBonus(int32_t &score, int32_t bonus) {
+    assert(std::abs(bonus) <= HistoryTable::MaxScore);
+    score += bonus - score * std::abs(bonus) / HistoryTable::MaxScore;
+}
+
+INLINE int32_t HistoryTable::score(Color color, PieceType type, Square to) const {
+    return this->table_[color][type][to];
+}
+
+
+
+// The killer moves of a single ply. Killers are quiet moves that caused a beta-cutoff in a sibling node, so they are likely to cause
+// a cutoff again, but they are not necessarily legal in the current position.
+class KillerMoves {
+public:
+    constexpr static uint32_t Count = 2;
+
+    // Adds a killer move. This should be called on beta-cutoffs of quiet moves.
+    INLINE void add(Move move);
+
+    [[nodiscard]] INLINE auto begin() const { return this->moves_.begin(); }
+    [[nodiscard]] INLINE auto end() const { return this->moves_.end(); }
+
+private:
+    std::array<Move, Count> moves_ = { Move::invalid(), Move::invalid() };
+};
+
+INLINE void KillerMoves::add(Move move) {
+    // Check if the move is already in the table.
+    for (Move killer : this->moves_) {
+        if (killer == move) {
+            return;
+        }
+    }
+
+    // Shift the moves down.
+    for (uint32_t i = KillerMoves::Count - 1; i > 0; i--) {
+        this->moves_[i] = this->moves_[i - 1];
+    }
+
+    // Insert the new move.
+    this->moves_[0] = move;
+}
+
+
+
+// The countermove heuristic: for each move (indexed by the moved piece and its destination), the last quiet move that refuted it
+// by causing a beta-cutoff in reply.
+class CountermoveTable {
+public:
+    CountermoveTable();
+
+    INLINE void set(Piece previousPiece, Square previousTo, Move move);
+    [[nodiscard]] INLINE Move get(Piece previousPiece, Square previousTo) const;
+
 private:
-    ColorMap<PieceTypeMap<SquareMap<uint32_t>>> table_;
+    // Move is not default constructible, so the moves are stored as raw bits. Zero-initialized bits are an invalid move.
+    static_assert(Move::invalid().bits() == 0);
+
+    ColorMap<PieceTypeMap<SquareMap<uint16_t>>> table_;
 };
 
-// Increments the history table. Call this on beta-cutoffs of quiet moves.
-INLINE void HistoryTable::add(Color color, const Board &board, Move move, uint16_t depth) {
-    uint16_t score = depth * depth;
-    this->table_[color][board.pieceAt(move.from()).type()][move.to()] += score;
+INLINE void CountermoveTable::set(Piece previousPiece, Square previousTo, Move move) {
+    this->table_[previousPiece.color()][previousPiece.type()][previousTo] = move.bits();
 }
 
-// Returns the history score for the given move. The returned score is normalized based off of the total sum of all history scores
-// so that at higher depths, the history scores aren't insanely high compared to at lower depths.
-[[nodiscard]] INLINE int32_t HistoryTable::score(Color color, PieceType type, Square to) const {
-    return static_cast<int32_t>(this->table_[color][type][to]);
+INLINE Move CountermoveTable::get(Piece previousPiece, Square previousTo) const {
+    return Move(this->table_[previousPiece.color()][previousPiece.type()][previousTo]);
 }
 
 
 
-class KillerTable {
+// Continuation history: a history table for each previous move (indexed by the moved piece and its destination), so that quiet
+// moves are also scored by how well they worked as a follow-up to that move. The same tables are used for the move made 1 ply ago
+// (the opponent's move) and 2 plies ago (our own previous move).
+class ContinuationHistory {
 public:
-    KillerTable();
-    ~KillerTable();
+    ContinuationHistory();
+
+    [[nodiscard]] INLINE HistoryTable &operator()(Piece previousPiece, Square previousTo);
 
-    // Resizes the killer table to the given size. This should be called at the start of each search, when the depth changes.
-    void resize(uint16_t size);
+    // Halves all continuation history scores (see HistoryTable::age).
+    void age();
 
-    // Adds a killer move to the table. This should be called on beta-cutoffs of quiet moves.
-    void add(uint16_t depth, Move move);
+private:
+    // The table is over two megabytes, so it is allocated on the heap (heuristic tables are sometimes constructed on the stack).
+    std::unique_ptr<ColorMap<PieceTypeMap<SquareMap<HistoryTable>>>> table_;
+};
+
+INLINE HistoryTable &ContinuationHistory::operator()(Piece previousPiece, Square previousTo) {
+    return (*this->table_)[previousPiece.color()][previousPiece.type()][previousTo];
+}
 
-    [[nodiscard]] INLINE const auto &operator[](uint16_t depth) const;
+
+
+// Capture history: history scores of captures, indexed by the moving piece, the destination square and the captured piece type.
+// Complements static exchange evaluation with which captures actually worked in the search.
+class CaptureHistory {
+public:
+    CaptureHistory();
+
+    // Updates the score of the given capture with a bonus (or malus, if negative), see HistoryTable::update. Must be called when
+    // the move is not made.
+    INLINE void update(Color color, const Board &board, Move move, int32_t bonus);
+
+    [[nodiscard]] INLINE int32_t score(Color color, PieceType type, Square to, PieceType captured) const;
+
+    // Halves all capture history scores (see HistoryTable::age).
+    void age();
 
 private:
-    constexpr static uint32_t MaxKillerMoves = 2;
-    using Ply = std::array<Move, MaxKillerMoves>;
-
-    // The KillerTable owns the memory for the table. We are using manual memory management to have better control over how
-    // resizing works. With std::vector, when it resizes, the elements are anchored to the front of the vector and new spaces is
-    // added to the end. However, because we are using depth as the index, we want the elements to be anchored to the end of the
-    // vector, and new space to be added to the front. This will keep the depth indices consistent between resizes.
-    uint16_t size_;
-    Ply *table_;
+    // Kings can never be captured, so the king slot of the captured piece type is unused.
+    ColorMap<PieceTypeMap<SquareMap<PieceTypeMap<int32_t>>>> table_;
 };
 
-const auto &KillerTable::operator[](uint16_t depth) const {
-    assert(depth < this->size_);
-    return this->table_[depth];
+INLINE void CaptureHistory::update(Color color, const Board &board, Move move, int32_t bonus) {
+    assert(move.isCapture());
+
+    // The captured pawn is not on the destination square for en passant captures.
+    PieceType captured = move.isEnPassant() ? PieceType::Pawn : board.pieceAt(move.to()).type();
+    HistoryTable::applyBonus(this->table_[color][board.pieceAt(move.from()).type()][move.to()][captured], bonus);
+}
+
+INLINE int32_t CaptureHistory::score(Color color, PieceType type, Square to, PieceType captured) const {
+    return this->table_[color][type][to][captured];
 }
 
 
 
 struct HeuristicTables {
     HistoryTable history;
-    KillerTable killers;
+    CountermoveTable countermoves;
+    ContinuationHistory continuations;
+    CaptureHistory captures;
 
     HeuristicTables();
+
+    // Ages the tables between searches. Countermoves are not aged, since they are always overwritten by newer refutations anyway.
+    void age();
+};
+
+
+
+// The history tables that are used to score the moves of a node.
+struct HistoryContext {
+    const HistoryTable &history;
+    const CaptureHistory &captures;
+
+    // The continuation histories of the moves made 1 and 2 plies ago, or nullptr if there was no such move (near the root, or after
+    // a null move).
+    std::array<const HistoryTable *, 2> continuations;
+
+    INLINE explicit HistoryContext(const HeuristicTables &heuristics)
+        : history(heuristics.history), captures(heuristics.captures), continuations{ nullptr, nullptr } { }
+    INLINE HistoryContext(const HeuristicTables &heuristics, const HistoryTable *previous, const HistoryTable *previous2)
+        : history(heuristics.history), captures(heuristics.captures), continuations{ previous, previous2 } { }
+
+    // Returns the combined history and continuation history score of a quiet move.
+    [[nodiscard]] INLINE int32_t quietScore(Color color, PieceType type, Square to) const;
 };
 
+INLINE int32_t HistoryContext::quietScore(Color color, PieceType type, Square to) const {
+    int32_t score = this->history.score(color, type, to);
+
+    for (const HistoryTable *continuation : this->continuations) {
+        if (continuation != nullptr) {
+            score += continuation->score(color, type, to);
+        }
+    }
+
+    return score;
+}
+
 } // namespace FKTB
@@ -19,24 +19,31 @@ namespace {
 template<Color Side, uint32_t Flags>
 class MoveScorer {
 public:
-    explicit MoveScorer(Board &board, const HistoryTable *history);
+    explicit MoveScorer(Board &board, const HistoryContext *history);
 
     [[nodiscard]] int32_t score(Move move);
 
 private:
+    // Good tactical moves are ordered before all quiet moves, and losing captures after all quiet moves (this matters when
+    // tactical and quiet moves are scored together). Quiet move scores are bounded by the history tables.
+    constexpr static int32_t GoodTactical = 100000;
+    constexpr static int32_t BadCapture = -100000;
+
+    constexpr static int32_t MvvWeight = 16;
+
     Board &board_;
-    const HistoryTable *history_;
+    const HistoryContext *history_;
 
     uint16_t gamePhase_;
 
-    [[nodiscard]] INLINE const HistoryTable &history() const {
+    [[nodiscard]] INLINE const HistoryContext &history() const {
         static_assert(Flags & MoveOrdering::Flags::History, "History flag is not set.");
         return *this->history_;
     }
 };
 
 template<Color Side, uint32_t Flags>
-MoveScorer<Side, Flags>::MoveScorer(Board &board, const HistoryTable *history) : board_(board), history_(history), gamePhase_(0) {
+MoveScorer<Side, Flags>::MoveScorer(Board &board, const HistoryContext *history) : board_(board), history_(history), gamePhase_(0) {
     if constexpr (Flags & MoveOrdering::Flags::History) {
         assert(history != nullptr && "History flag is set but history table is null.");
     } else {
@@ -62,24 +69,41 @@ int32_t MoveScorer<Side, Flags>::score(Move move) {
 
     // Tactical moves
     if constexpr (Flags & MoveOrdering::Flags::Tactical) {
-        // Captures
+        // Captures are ordered by the value of the captured piece (MVV) and capture history. Static exchange evaluation only decides
+        // whether the capture is a good or a losing one, and is not needed at all if the captured piece is worth at least as much as
+        // the capturing piece.
         if (move.isCapture()) {
             isQuiet = false;
 
-            // Static exchange evaluation
-            score += See::evaluate<Side>(move, board);
+            PieceType captured = move.isEnPassant() ? PieceType::Pawn : board.pieceAt(move.to()).type();
+
+            score += PieceMaterial::value(captured) * MoveScorer::MvvWeight;
+
+            if constexpr (Flags & MoveOrdering::Flags::History) {
+                score += this->history().captures.score(Side, piece.type(), move.to(), captured);
+            }
+
+            bool isGood = (piece.type() != PieceType::King && PieceMaterial::value(captured) >= piece.material())
+                || See::isAtLeast<Side>(move, board, 0);
+            score += isGood ? MoveScorer::GoodTactical : MoveScorer::BadCapture;
         }
 
         // Promotions
         if (move.isPromotion()) {
+            isQuiet = false;
+
             score += PieceMaterial::value(move.promotion()) * 10;
+
+            if (!move.isCapture()) {
+                score += MoveScorer::GoodTactical;
+            }
         }
     }
 
     // History heuristics
     if constexpr (Flags & MoveOrdering::Flags::History) {
         if (isQuiet) {
-            score += this->history().score(Side, piece.type(), move.to());
+            score += this->history().quietScore(Side, piece.type(), move.to());
         }
     }
 
@@ -105,7 +129,7 @@ int32_t MoveScorer<Side, Flags>::score(Move move) {
 
 
 template<Color Side, uint32_t Flags>
-void MoveOrdering::score(MovePriorityQueue &moves, Board &board, const HistoryTable *history) {
+void MoveOrdering::score(MovePriorityQueue &moves, Board &board, const HistoryContext *history) {
     MoveScorer<Side, Flags> scorer(board, history);
 
     for (MoveEntry *entry = moves.start(); entry != moves.end(); ++entry) {
@@ -116,16 +140,16 @@ void MoveOrdering::score(MovePriorityQueue &moves, Board &board, const HistoryTa
 
 
 template<Color Side, uint32_t Flags>
-INLINE void scoreRoot(RootMoveList &moves, Board &board, const HistoryTable *history) {
+INLINE void scoreRoot(RootMoveList &moves, Board &board, const HistoryContext *history) {
     MoveScorer<Side, Flags> scorer(board, history);
 
-    for (MoveEntry &entry : moves.moves()) {
+    for (RootMoveEntry &entry : moves.moves()) {
         entry.score = scorer.score(entry.move);
     }
 }
 
 template<uint32_t Flags>
-void MoveOrdering::score(RootMoveList &moves, Board &board, const HistoryTable *history) {
+void MoveOrdering::score(RootMoveList &moves, Board &board, const HistoryContext *history) {
     if (board.turn() == Color::White) {
         scoreRoot<Color::White, Flags>(moves, board, history);
     } else {
@@ -134,19 +158,21 @@ void MoveOrdering::score(RootMoveList &moves, Board &board, const HistoryTable *
 }
 
 // @formatter:off
-template void MoveOrdering::score<Color::White, MoveOrdering::Type::Quiet>(MovePriorityQueue &, Board &, const HistoryTable *);
-template void MoveOrdering::score<Color::Black, MoveOrdering::Type::Quiet>(MovePriorityQueue &, Board &, const HistoryTable *);
-template void MoveOrdering::score<Color::White, MoveOrdering::Type::Tactical>(MovePriorityQueue &, Board &, const HistoryTable *);
-template void MoveOrdering::score<Color::Black, MoveOrdering::Type::Tactical>(MovePriorityQueue &, Board &, const HistoryTable *);
-template void MoveOrdering::score<Color::White, MoveOrdering::Type::All>(MovePriorityQueue &, Board &, const HistoryTable *);
-template void MoveOrdering::score<Color::Black, MoveOrdering::Type::All>(MovePriorityQueue &, Board &, const HistoryTable *);
-template void MoveOrdering::score<Color::White, MoveOrdering::Type::AllNoHistory>(MovePriorityQueue &, Board &, const HistoryTable *);
-template void MoveOrdering::score<Color::Black, MoveOrdering::Type::AllNoHistory>(MovePriorityQueue &, Board &, const HistoryTable *);
-
-template void MoveOrdering::score<MoveOrdering::Type::Quiet>(RootMoveList &, Board &, const HistoryTable *);
-template void MoveOrdering::score<MoveOrdering::Type::Tactical>(RootMoveList &, Board &, const HistoryTable *);
-template void MoveOrdering::score<MoveOrdering::Type::All>(RootMoveList &, Board &, const HistoryTable *);
-template void MoveOrdering::score<MoveOrdering::Type::AllNoHistory>(RootMoveList &, Board &, const HistoryTable *);
+template void MoveOrdering::score<Color::White, MoveOrdering::Type::Quiet>(MovePriorityQueue &, Board &, const HistoryContext *);
+template void MoveOrdering::score<Color::Black, MoveOrdering::Type::Quiet>(MovePriorityQueue &, Board &, const HistoryContext *);
+template void MoveOrdering::score<Color::White, MoveOrdering::Type::Tactical>(MovePriorityQueue &, Board &, const HistoryContext *);
+template void MoveOrdering::score<Color::Black, MoveOrdering::Type::Tactical>(MovePriorityQueue &, Board &, const HistoryContext *);
+template void MoveOrdering::score<Color::White, MoveOrdering::Type::TacticalNoHistory>(MovePriorityQueue &, Board &, const HistoryContext *);
+template void MoveOrdering::score<Color::Black, MoveOrdering::Type::TacticalNoHistory>(MovePriorityQueue &, Board &, const HistoryContext *);
+template void MoveOrdering::score<Color::White, MoveOrdering::Type::All>(MovePriorityQueue &, Board &, const HistoryContext *);
+template void MoveOrdering::score<Color::Black, MoveOrdering::Type::All>(MovePriorityQueue &, Board &, const HistoryContext *);
+template void MoveOrdering::score<Color::White, MoveOrdering::Type::AllNoHistory>(MovePriorityQueue &, Board &, const HistoryContext *);
+template void MoveOrdering::score<Color::Black, MoveOrdering::Type::AllNoHistory>(MovePriorityQueue &, Board &, const HistoryContext *);
+
+template void MoveOrdering::score<MoveOrdering::Type::Quiet>(RootMoveList &, Board &, const HistoryContext *);
+template void MoveOrdering::score<MoveOrdering::Type::Tactical>(RootMoveList &, Board &, const HistoryContext *);
+template void MoveOrdering::score<MoveOrdering::Type::All>(RootMoveList &, Board &, const HistoryContext *);
+template void MoveOrdering::score<MoveOrdering::Type::AllNoHistory>(RootMoveList &, Board &, const HistoryContext *);
 // @formatter:on
 
 } // namespace FKTB
@@ -15,7 +15,7 @@ namespace FKTB::MoveOrdering {
 namespace Flags {
     constexpr uint32_t Quiet    = 0b0001;   // Use quiet move ordering.
     constexpr uint32_t Tactical = 0b0010;   // Use tactical move ordering.
-    constexpr uint32_t History  = 0b0100;   // Use history heuristic.
+    constexpr uint32_t History  = 0b0100;   // Use history heuristics (quiet and capture history).
 } // namespace Flags
 
 // Only these sets of flags will link properly with the score method.
@@ -23,8 +23,11 @@ namespace Type {
     // Scores quiet moves with history heuristic.
     constexpr uint32_t Quiet = Flags::Quiet | Flags::History;
 
-    // Scores tactical moves without history heuristic.
-    constexpr uint32_t Tactical = Flags::Tactical;
+    // Scores tactical moves with capture history.
+    constexpr uint32_t Tactical = Flags::Tactical | Flags::History;
+
+    // Scores tactical moves without capture history.
+    constexpr uint32_t TacticalNoHistory = Flags::Tactical;
 
     // Scores all moves with history heuristic.
     constexpr uint32_t All = Flags::Quiet | Flags::Tactical | Flags::History;
@@ -38,11 +41,11 @@ namespace Type {
 // Scores the moves in the given list.
 // Pass nullptr into history if history heuristic is not used.
 template<Color Side, uint32_t Flags>
-void score(MovePriorityQueue &moves, Board &board, const HistoryTable *history);
+void score(MovePriorityQueue &moves, Board &board, const HistoryContext *history);
 
 // Scores the moves in the given list.
 // Pass nullptr into history if history heuristic is not used.
 template<uint32_t Flags>
-void score(RootMoveList &moves, Board &board, const HistoryTable *history);
+void score(RootMoveList &moves, Board &board, const HistoryContext *history);
 
 } // namespace FKTB::MoveOrdering
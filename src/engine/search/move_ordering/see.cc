@@ -41,11 +41,15 @@ constexpr PieceTypeMap<int32_t> Values = {
 // Returns a bitboard of all attackers of a square of either color.
 INLINE Bitboard findAllAttackers(Square square, Bitboard diagonalSliders, Bitboard orthogonalSliders, Bitboard occupied,
     const Board &board) {
+    // Kings do not have bitboards, so they are added separately.
+    Bitboard kings = (1ULL << board.king(Color::White)) | (1ULL << board.king(Color::Black));
+
     return (Bitboards::pawnAttacks<Color::White>(square) & board.bitboard(Piece::pawn(Color::Black)))
         | (Bitboards::pawnAttacks<Color::Black>(square) & board.bitboard(Piece::pawn(Color::White)))
         | (Bitboards::knightAttacks(square) & board.composite(PieceType::Knight))
         | (Bitboards::bishopAttacks(square, occupied) & diagonalSliders)
-        | (Bitboards::rookAttacks(square, occupied) & orthogonalSliders);
+        | (Bitboards::rookAttacks(square, occupied) & orthogonalSliders)
+        | (Bitboards::kingAttacks(square) & kings);
 }
 
 
@@ -112,24 +116,21 @@ int32_t See::evaluate(Square square, const Board &board) {
             break;
         }
 
-        // Add to the score
+        // Add to the score. There is no pruning here, since pruning the swap list is only sound if it is done before the capture
+        // material is known (see isAtLeast for the fast version).
         scores[depth] = captureMaterial - scores[depth - 1];
 
-        // Pruning
-        if (std::max(-scores[depth - 1], scores[depth]) < 0) {
-            break;
-        }
-
         // Remove the attacker from the bitboards
         occupied ^= attacker.bitboard;
         attackers ^= attacker.bitboard;
         diagonalSliders &= ~attacker.bitboard;
         orthogonalSliders &= ~attacker.bitboard;
 
-        // Need to update attackers if it is possible that the attacker was x-rayed
+        // Need to update attackers if it is possible that the attacker was x-rayed (queens can uncover both kinds of x-rays).
         if (attacker.bitboard & diagonalXRay) {
             attackers |= (Bitboards::bishopAttacks(square, occupied) & diagonalSliders);
-        } else if (attacker.bitboard & orthogonalXRay) {
+        }
+        if (attacker.bitboard & orthogonalXRay) {
             attackers |= (Bitboards::rookAttacks(square, occupied) & orthogonalSliders);
         }
 
@@ -168,9 +169,103 @@ int32_t See::evaluate(Move move, Board &board) {
 
 
 
+// Based on Stockfish's see_ge. Instead of building the whole swap list, this keeps track of the balance relative to the threshold
+// and whose turn it is, so it can stop as soon as the side to move cannot change the outcome.
+template<Color Side>
+bool See::isAtLeast(Move move, const Board &board, int32_t threshold) {
+    // Castling can never lose material.
+    if (move.isCastle()) {
+        return threshold <= 0;
+    }
+
+    Square from = move.from();
+    Square to = move.to();
+
+    // The piece that will be standing on the target square after the move.
+    PieceType moved = move.isPromotion() ? move.promotion() : board.pieceAt(from).type();
+
+    // The balance after the move if the opponent does not recapture.
+    int32_t swap = -threshold;
+    if (move.isCapture()) {
+        swap += SeeMaterial::value(move.isEnPassant() ? PieceType::Pawn : board.pieceAt(to).type());
+    }
+    if (move.isPromotion()) {
+        swap += SeeMaterial::value(moved) - SeeMaterial::value(PieceType::Pawn);
+    }
+    if (swap < 0) {
+        return false;
+    }
+
+    // The balance if the opponent recaptures the moved piece and we do not recapture back.
+    swap = SeeMaterial::value(moved) - swap;
+    if (swap <= 0) {
+        return true;
+    }
+
+    Bitboard occupied = board.occupied() ^ (1ULL << from) ^ (1ULL << to);
+    if (move.isEnPassant()) {
+        occupied ^= Bitboard(1ULL << to).shiftBackward<Side>(1);
+    }
+
+    Bitboard diagonalSliders = board.composite(PieceType::Bishop) | board.composite(PieceType::Queen);
+    Bitboard orthogonalSliders = board.composite(PieceType::Rook) | board.composite(PieceType::Queen);
+    Bitboard attackers = findAllAttackers(to, diagonalSliders, orthogonalSliders, occupied, board);
+
+    Color side = Side;
+
+    // Whether the outcome is at least the threshold if the exchange stopped now. The opponent recaptures first, so we start out
+    // winning (we already checked that the opponent recapturing once is not enough to bring us below the threshold).
+    bool result = true;
+
+    while (true) {
+        side = ~side;
+        attackers &= occupied;
+
+        Bitboard sideAttackers = attackers & board.composite(side);
+        if (!sideAttackers) {
+            break;
+        }
+
+        result = !result;
+
+        // Capture with the least valuable attacker. If even giving that attacker away would not let the other side turn the
+        // outcome around, the exchange is decided.
+        PieceType type = PieceType::Pawn;
+        while (type != PieceType::King && !(sideAttackers & board.bitboard({ side, type }))) {
+            type = static_cast<PieceType>(type + 1);
+        }
+
+        if (type == PieceType::King) {
+            // The king can only capture if the square is no longer defended, otherwise the capture would be illegal.
+            return (attackers & ~board.composite(side)) ? !result : result;
+        }
+
+        swap = SeeMaterial::value(type) - swap;
+        if (swap < static_cast<int32_t>(result)) {
+            break;
+        }
+
+        occupied ^= Intrinsics::blsi(sideAttackers & board.bitboard({ side, type }));
+
+        // Add any x-ray attackers that were behind the attacker
+        if (type == PieceType::Pawn || type == PieceType::Bishop || type == PieceType::Queen) {
+            attackers |= Bitboards::bishopAttacks(to, occupied) & diagonalSliders;
+        }
+        if (type == PieceType::Rook || type == PieceType::Queen) {
+            attackers |= Bitboards::rookAttacks(to, occupied) & orthogonalSliders;
+        }
+    }
+
+    return result;
+}
+
+
+
 template int32_t See::evaluate<Color::White>(Square, const Board &);
 template int32_t See::evaluate<Color::Black>(Square, const Board &);
 template int32_t See::evaluate<Color::White>(Move, Board &);
 template int32_t See::evaluate<Color::Black>(Move, Board &);
+template bool See::isAtLeast<Color::White>(Move, const Board &, int32_t);
+template bool See::isAtLeast<Color::Black>(Move, const Board &, int32_t);
 
 } // namespace FKTB
@@ -17,4 +17,10 @@ int32_t evaluate(Square square, const Board &board);
 template<Color Side>
 int32_t evaluate(Move move, Board &board);
 
+// Returns whether the static exchange evaluation of the given move is at least the threshold. Much cheaper than evaluate, since it
+// does not make the move, and stops as soon as the outcome relative to the threshold is known. The move does not have to be a
+// capture.
+template<Color Side>
+bool isAtLeast(Move move, const Board &board, int32_t threshold);
+
 } // namespace FKTB::See
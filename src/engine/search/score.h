@@ -8,6 +8,9 @@ namespace FKTB::Score {
 
 constexpr static int32_t Draw = 0;
 
+// Placeholder for scores that have not been computed. Outside the range of every real score, including mates.
+constexpr static int32_t None = INT32_MIN;
+
 INLINE constexpr int32_t mateIn(uint16_t ply) { return -INT32_MAX + ply; }
 
 INLINE constexpr bool isMate(int32_t score) {
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+#include "engine/inline.h"
+
+// Tunable parameters of the search. The pruning techniques can be turned off individually, so that their effect can be measured
+// by comparing two builds.
+namespace FKTB::SearchParameters {
+
+// Reverse futility pruning: at shallow depth non-PV nodes, if the static evaluation is so far above beta that even a margin per
+// remaining ply cannot bring it back down, the node fails high without searching any moves.
+constexpr bool ReverseFutilityPruning = true;
+constexpr uint16_t ReverseFutilityMaxDepth = 6;
+constexpr int32_t ReverseFutilityMarginPerDepth = 90;
+
+[[nodiscard]] INLINE constexpr int32_t reverseFutilityMargin(uint16_t depth) {
+    return ReverseFutilityMarginPerDepth * depth;
+}
+
+// Razoring: at shallow depth non-PV nodes, if the static evaluation is so far below alpha that only tactics could save the node,
+// drop into quiescence search, and fail low if it confirms that there are none.
+constexpr bool Razoring = true;
+constexpr uint16_t RazoringMaxDepth = 3;
+constexpr int32_t RazoringMarginBase = 250;
+constexpr int32_t RazoringMarginPerDepth = 200;
+
+[[nodiscard]] INLINE constexpr int32_t razoringMargin(uint16_t depth) {
+    return RazoringMarginBase + RazoringMarginPerDepth * depth;
+}
+
+// Null move pruning: give the opponent a free move and search with a reduced depth. If the score is still at least beta, the node
+// fails high. The reduction grows with the depth and with how far the static evaluation is above beta. Null move pruning is not
+// done when the side to move only has pawns, since zugzwang is common there, and at high depth the fail-high is verified by a
+// reduced search without null moves.
+constexpr uint16_t NullMoveMinDepth = 3;
+constexpr uint16_t NullMoveBaseReduction = 3;
+constexpr uint16_t NullMoveDepthDivisor = 4;
+constexpr int32_t NullMoveEvalDivisor = 200;
+constexpr uint16_t NullMoveMaxEvalReduction = 3;
+constexpr uint16_t NullMoveVerificationDepth = 10;
+
+// The difference between the static evaluation and beta is computed with 64 bits, since beta can be close to -INT32_MAX.
+[[nodiscard]] INLINE constexpr uint16_t nullMoveReduction(uint16_t depth, int32_t staticEval, int32_t beta) {
+    int64_t evalMargin = static_cast<int64_t>(staticEval) - beta;
+    int64_t evalReduction = std::clamp<int64_t>(evalMargin / NullMoveEvalDivisor, 0, NullMoveMaxEvalReduction);
+    return NullMoveBaseReduction + depth / NullMoveDepthDivisor + static_cast<uint16_t>(evalReduction);
+}
+
+// ProbCut: at non-PV nodes, if a good capture beats beta by a margin even in a search of reduced depth, a full-depth search would
+// very likely fail high as well. Only captures whose SEE could reach that margin on their own are tried.
+constexpr bool ProbCut = true;
+constexpr uint16_t ProbCutMinDepth = 5;
+constexpr uint16_t ProbCutReduction = 4;
+constexpr int32_t ProbCutMargin = 125;
+
+// Internal iterative reductions: nodes without a hash move are searched with one ply less. Either the node was never searched
+// before, so it is unlikely to be important, or its entry was replaced. In both cases, the reduced search stores a hash move for
+// the next iteration, which is much cheaper than a separate shallow search to find one.
+constexpr bool InternalIterativeReductions = true;
+constexpr uint16_t IirMinDepth = 4;
+
+// Futility pruning at frontier nodes (depth 1): skip the quiet moves if the static evaluation plus a margin cannot raise alpha.
+constexpr int32_t FutilityMargin = 300;
+
+// The move-level pruning below only applies to quiet moves at non-PV nodes that are not in check, and only once a move has been
+// searched without being mated, so that a node can never end up with no moves searched at all.
+
+// Late move pruning: at shallow depth, skip the remaining quiet moves once enough quiet moves have been searched. Quiet moves are
+// ordered by history, so the late ones are unlikely to cause a cutoff.
+constexpr bool LateMovePruning = true;
+constexpr uint16_t LateMovePruningMaxDepth = 8;
+
+[[nodiscard]] INLINE constexpr uint16_t lateMovePruningCount(uint16_t depth) {
+    return 3 + depth * depth;
+}
+
+// Futility pruning of quiet moves: at shallow depth, skip the remaining quiet moves if the static evaluation plus a margin per
+// remaining ply cannot raise alpha.
+constexpr bool QuietFutilityPruning = true;
+constexpr uint16_t QuietFutilityMaxDepth = 5;
+constexpr int32_t QuietFutilityMarginBase = 100;
+constexpr int32_t QuietFutilityMarginPerDepth = 120;
+
+[[nodiscard]] INLINE constexpr int32_t quietFutilityMargin(uint16_t depth) {
+    return QuietFutilityMarginBase + QuietFutilityMarginPerDepth * depth;
+}
+
+// SEE pruning of quiet moves: at shallow depth, skip quiet moves that hang more material than a margin per remaining ply.
+constexpr bool QuietSeePruning = true;
+constexpr uint16_t QuietSeeMaxDepth = 6;
+constexpr int32_t QuietSeeMarginPerDepth = 60;
+
+[[nodiscard]] INLINE constexpr int32_t quietSeeThreshold(uint16_t depth) {
+    return -QuietSeeMarginPerDepth * depth;
+}
+
+// Late move reductions: late quiet moves are first searched with a null window at a reduced depth, and only searched again at
+// full depth if they unexpectedly raise alpha. The base reduction is LmrBase + ln(depth) * ln(moveNumber) / LmrDivisor. Moves are
+// reduced less at PV nodes, when they give check, or when they have a good history score.
+constexpr uint16_t LmrMinDepth = 3;
+constexpr uint16_t LmrMinMoveNumber = 4;
+constexpr double LmrBase = 0.75;
+constexpr double LmrDivisor = 2.25;
+constexpr int32_t LmrHistoryDivisor = 8192;
+
+} // namespace FKTB::SearchParameters
@@ -0,0 +1,22 @@
+#include "search_stack.h"
+
+namespace FKTB {
+
+std::vector<Move> PrincipalVariation::moves() const {
+    std::vector<Move> moves;
+    moves.reserve(this->length_);
+    for (uint16_t i = 0; i < this->length_; i++) {
+        moves.push_back((*this)[i]);
+    }
+    return moves;
+}
+
+
+
+SearchStack::SearchStack() : frames_(std::make_unique<SearchFrame[]>(SearchStack::FrameCount)) {
+    for (uint32_t i = SearchStack::SentinelCount; i < SearchStack::FrameCount; i++) {
+        this->frames_[i].ply = i - SearchStack::SentinelCount;
+    }
+}
+
+} // namespace FKTB
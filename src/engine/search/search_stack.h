@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <memory>
+#include <cassert>
+
+#include "score.h"
+#include "engine/inline.h"
+#include "engine/move/move.h"
+#include "engine/move/move_list.h"
+#include "engine/search/move_ordering/heuristics.h"
+
+namespace FKTB {
+
+// The maximum depth that can be searched.
+constexpr uint16_t MaxSearchDepth = 128;
+
+// A triangular principal variation entry: the best line found so far starting at a ply.
+class PrincipalVariation {
+public:
+    INLINE PrincipalVariation() : length_(0) { }
+
+    INLINE constexpr void clear() { this->length_ = 0; }
+
+    // Sets the line to the given move followed by the line of the child ply.
+    INLINE void update(Move move, const PrincipalVariation &child);
+
+    [[nodiscard]] INLINE constexpr uint16_t length() const { return this->length_; }
+    [[nodiscard]] INLINE constexpr Move operator[](uint16_t index) const { return Move(this->moves_[index]); }
+
+    [[nodiscard]] std::vector<Move> moves() const;
+
+private:
+    uint16_t length_;
+
+    // Move is not default constructible, so the moves are stored as raw bits.
+    std::array<uint16_t, MaxSearchDepth + 1> moves_;
+};
+
+INLINE void PrincipalVariation::update(Move move, const PrincipalVariation &child) {
+    assert(child.length_ < this->moves_.size());
+
+    this->moves_[0] = move.bits();
+    std::copy(child.moves_.begin(), child.moves_.begin() + child.length_, this->moves_.begin() + 1);
+    this->length_ = child.length_ + 1;
+}
+
+
+
+// A list of the moves that were searched from a ply.
+template<uint32_t Capacity>
+class SearchedMoves {
+public:
+    INLINE SearchedMoves() : size_(0) { }
+
+    INLINE void clear() { this->size_ = 0; }
+    INLINE void push(Move move);
+
+    [[nodiscard]] INLINE uint16_t size() const { return this->size_; }
+    [[nodiscard]] INLINE Move operator[](uint16_t index) const { return Move(this->moves_[index]); }
+
+private:
+    uint16_t size_;
+
+    // Move is not default constructible, so the moves are stored as raw bits.
+    std::array<uint16_t, Capacity> moves_;
+};
+
+template<uint32_t Capacity>
+INLINE void SearchedMoves<Capacity>::push(Move move) {
+    assert(this->size_ < Capacity);
+    this->moves_[this->size_++] = move.bits();
+}
+
+
+
+// The state of the search at a single ply. Frames are aligned to cache lines so that the hot fields at the start of a frame
+// (killers, static eval, current move) never share a cache line with the move buffer of the previous frame.
+struct alignas(64) SearchFrame {
+    uint16_t ply = 0;
+
+    // The move currently being searched from this ply, or an invalid move while searching a null move.
+    Move currentMove = Move::invalid();
+
+    // The continuation history of the current move, or nullptr while searching a null move.
+    HistoryTable *continuation = nullptr;
+
+    // The static evaluation of the position at this ply, or Score::None if it has not been evaluated.
+    int32_t staticEval = Score::None;
+
+    KillerMoves killers;
+
+    PrincipalVariation pv;
+
+    // The quiet moves and captures that were searched from this ply without causing a beta-cutoff, so that they can be given a
+    // history malus if a later move does.
+    SearchedMoves<MaxMoveCount> searchedQuiets;
+    SearchedMoves<MaxTacticalCount> searchedCaptures;
+
+    // Using AlignedMoveEntry leaves the buffer uninitialized (see move_list.h).
+    AlignedMoveEntry moveBuffer[MaxMoveCount];
+
+    [[nodiscard]] INLINE MoveEntry *moves() { return MoveEntry::fromAligned(this->moveBuffer); }
+};
+
+// A preallocated stack of search frames, indexed by ply. Each search thread owns one, so that the search never allocates and
+// per-ply state such as killers does not mix between unrelated subtrees. Recursive searches pass a pointer to their frame, and the
+// child's frame is always the next one.
+//
+// There are sentinel frames before the root frame, so that the frames of the previous plies can be accessed without bounds checks.
+// They never have a current move.
+class SearchStack {
+public:
+    SearchStack();
+
+    [[nodiscard]] INLINE SearchFrame *root() { return this->frames_.get() + SearchStack::SentinelCount; }
+
+    // The number of frames before the root frame.
+    constexpr static uint32_t SentinelCount = 2;
+
+private:
+    // Every ply from the root up to and including MaxSearchDepth has a frame.
+    constexpr static uint32_t FrameCount = SearchStack::SentinelCount + MaxSearchDepth + 1;
+
+    std::unique_ptr<SearchFrame[]> frames_;
+};
+
+} // namespace FKTB
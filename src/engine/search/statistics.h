@@ -3,44 +3,157 @@
 #include <cstdint>
 #include <atomic>
 #include <chrono>
+#include <vector>
+#include <algorithm>
 
 #include "engine/inline.h"
 
 namespace FKTB {
 
-// Stores information like node count and transposition hits about the current search.
-// This class is thread safe.
-class SearchStatistics {
+// The statistics of a single search thread. Only the thread that owns the counters writes to them, so incrementing them is a plain
+// load and store instead of an atomic read-modify-write. They are still atomics so that they can be read from other threads while
+// searching. Aligned to a cache line, so that the counters of different threads never share one.
+class alignas(64) ThreadStatistics {
 public:
-    INLINE SearchStatistics();
-
     INLINE void reset();
 
-    INLINE void incrementNodeCount() { this->nodeCount_.fetch_add(1, std::memory_order_relaxed); }
-    INLINE void incrementTranspositionHits() { this->transpositionHits_.fetch_add(1, std::memory_order_relaxed); }
+    INLINE void incrementNodeCount() { increment(this->nodeCount_); }
+    INLINE void incrementTranspositionHits() { increment(this->transpositionHits_); }
+
+    // Quiescence nodes are also counted in the total node count.
+    INLINE void incrementQuiescenceNodeCount() { increment(this->quiescenceNodeCount_); }
+    INLINE void incrementQuiescenceSeePrunes() { increment(this->quiescenceSeePrunes_); }
+    INLINE void incrementQuiescenceDeltaPrunes() { increment(this->quiescenceDeltaPrunes_); }
+
+    // Records that a node at the given ply was searched, for the selective depth.
+    INLINE void updateSelectiveDepth(uint16_t ply) {
+        if (ply > this->selectiveDepth_.load(std::memory_order_relaxed)) {
+            this->selectiveDepth_.store(ply, std::memory_order_relaxed);
+        }
+    }
 
     [[nodiscard]] INLINE uint64_t nodeCount() const { return this->nodeCount_.load(std::memory_order_relaxed); }
     [[nodiscard]] INLINE uint64_t transpositionHits() const { return this->transpositionHits_.load(std::memory_order_relaxed); }
+    [[nodiscard]] INLINE uint64_t quiescenceNodeCount() const { return this->quiescenceNodeCount_.load(std::memory_order_relaxed); }
+    [[nodiscard]] INLINE uint64_t quiescenceSeePrunes() const { return this->quiescenceSeePrunes_.load(std::memory_order_relaxed); }
+    [[nodiscard]] INLINE uint64_t quiescenceDeltaPrunes() const { return this->quiescenceDeltaPrunes_.load(std::memory_order_relaxed); }
+    [[nodiscard]] INLINE uint16_t selectiveDepth() const { return this->selectiveDepth_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> nodeCount_ = 0;
+    std::atomic<uint64_t> transpositionHits_ = 0;
+
+    // Quiescence search statistics. The prune counters count the captures that were skipped because they lose material (SEE
+    // pruning), or because even winning the captured piece could not raise alpha (delta pruning).
+    std::atomic<uint64_t> quiescenceNodeCount_ = 0;
+    std::atomic<uint64_t> quiescenceSeePrunes_ = 0;
+    std::atomic<uint64_t> quiescenceDeltaPrunes_ = 0;
+
+    // The highest ply that was searched, including quiescence search.
+    std::atomic<uint16_t> selectiveDepth_ = 0;
+
+    INLINE static void increment(std::atomic<uint64_t> &counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+};
+
+INLINE void ThreadStatistics::reset() {
+    this->nodeCount_.store(0, std::memory_order_relaxed);
+    this->transpositionHits_.store(0, std::memory_order_relaxed);
+    this->quiescenceNodeCount_.store(0, std::memory_order_relaxed);
+    this->quiescenceSeePrunes_.store(0, std::memory_order_relaxed);
+    this->quiescenceDeltaPrunes_.store(0, std::memory_order_relaxed);
+    this->selectiveDepth_.store(0, std::memory_order_relaxed);
+}
+
+
+
+// Stores information like node count and transposition hits about the current search, with separate counters for every search
+// thread (see ThreadStatistics). The counters are only added up when they are read, e.g. when a result is reported or the node
+// limit is checked.
+// This class is thread safe, except for reset(), which must not be called while searching.
+class SearchStatistics {
+public:
+    INLINE explicit SearchStatistics(uint32_t threadCount = 1);
+
+    INLINE void reset();
+
+    // Changes the number of threads that have counters. Resets all counters. Must not be called while searching.
+    INLINE void resize(uint32_t threadCount) { this->threads_ = std::vector<ThreadStatistics>(threadCount); }
+
+    [[nodiscard]] INLINE ThreadStatistics &thread(uint32_t index) { return this->threads_[index]; }
+
+    INLINE void recordStopLatency(std::chrono::microseconds latency) {
+        this->stopLatency_.store(latency.count(), std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] INLINE uint64_t nodeCount() const {
+        return this->sum([](const ThreadStatistics &thread) { return thread.nodeCount(); });
+    }
+    [[nodiscard]] INLINE uint64_t transpositionHits() const {
+        return this->sum([](const ThreadStatistics &thread) { return thread.transpositionHits(); });
+    }
+    [[nodiscard]] INLINE uint64_t quiescenceNodeCount() const {
+        return this->sum([](const ThreadStatistics &thread) { return thread.quiescenceNodeCount(); });
+    }
+    [[nodiscard]] INLINE uint64_t quiescenceSeePrunes() const {
+        return this->sum([](const ThreadStatistics &thread) { return thread.quiescenceSeePrunes(); });
+    }
+    [[nodiscard]] INLINE uint64_t quiescenceDeltaPrunes() const {
+        return this->sum([](const ThreadStatistics &thread) { return thread.quiescenceDeltaPrunes(); });
+    }
+    [[nodiscard]] INLINE uint16_t selectiveDepth() const;
+    [[nodiscard]] INLINE std::chrono::microseconds stopLatency() const {
+        return std::chrono::microseconds(this->stopLatency_.load(std::memory_order_relaxed));
+    }
     [[nodiscard]] INLINE std::chrono::milliseconds elapsed() const;
 
 private:
     std::chrono::steady_clock::time_point start_;
-    std::atomic<uint64_t> nodeCount_;
-    std::atomic<uint64_t> transpositionHits_;
+    std::vector<ThreadStatistics> threads_;
+
+    // How long it took the search to stop after it was halted, either by one of its limits or from another thread (0 if it was not
+    // halted in the middle of an iteration).
+    std::atomic<int64_t> stopLatency_;
+
+    template<typename Counter>
+    [[nodiscard]] INLINE uint64_t sum(Counter counter) const;
 };
 
-INLINE SearchStatistics::SearchStatistics() : nodeCount_(0), transpositionHits_(0), start_() {
+INLINE SearchStatistics::SearchStatistics(uint32_t threadCount) : start_(), threads_(threadCount), stopLatency_(0) {
     this->start_ = std::chrono::steady_clock::now();
 }
 
 INLINE void SearchStatistics::reset() {
-    this->nodeCount_.store(0, std::memory_order_relaxed);
-    this->transpositionHits_.store(0, std::memory_order_relaxed);
+    for (ThreadStatistics &thread : this->threads_) {
+        thread.reset();
+    }
+
+    this->stopLatency_.store(0, std::memory_order_relaxed);
     this->start_ = std::chrono::steady_clock::now();
 }
 
+INLINE uint16_t SearchStatistics::selectiveDepth() const {
+    uint16_t selectiveDepth = 0;
+    for (const ThreadStatistics &thread : this->threads_) {
+        selectiveDepth = std::max(selectiveDepth, thread.selectiveDepth());
+    }
+
+    return selectiveDepth;
+}
+
 INLINE std::chrono::milliseconds SearchStatistics::elapsed() const {
     return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - this->start_);
 }
 
+template<typename Counter>
+INLINE uint64_t SearchStatistics::sum(Counter counter) const {
+    uint64_t total = 0;
+    for (const ThreadStatistics &thread : this->threads_) {
+        total += counter(thread);
+    }
+
+    return total;
+}
+
 } // namespace FKTB
@@ -0,0 +1,141 @@
+#include "time_manager.h"
+
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+#include <chrono>
+
+#include "score.h"
+#include "iterative_search.h"
+
+namespace FKTB {
+
+namespace {
+
+// The number of moves that the remaining time is divided between when there is no moves to go, assuming the game will last that
+// many more moves.
+constexpr uint16_t DefaultMovesToGo = 40;
+
+// Moves to go are clamped to this, since games rarely last that long, so the time is never divided between more moves than this.
+constexpr uint16_t MaxMovesToGo = 50;
+
+// The fraction of the increment that is added to the time for each move. Not all of it, so that some of the increment is saved
+// for later moves.
+constexpr double IncrementUsage = 0.75;
+
+// The hard limit is this many times the base time, but never more than this fraction of the remaining time.
+constexpr double HardLimitFactor = 4.0;
+constexpr double MaxHardLimitUsage = 0.75;
+
+// Best move stability: the soft limit is scaled from MaxStabilityScale (the best move just changed) down to MinStabilityScale,
+// by StabilityScaleStep for each iteration the best move did not change.
+constexpr double MaxStabilityScale = 1.3;
+constexpr double MinStabilityScale = 0.7;
+constexpr double StabilityScaleStep = 0.1;
+
+// Score drops: the soft limit is extended by up to MaxScoreDropScale if the score dropped since the previous iteration, linearly up
+// to a drop of ScoreDropForMaxScale.
+constexpr double MaxScoreDropScale = 1.5;
+constexpr int32_t ScoreDropForMaxScale = 100;
+
+// Best move node fraction: the more nodes are spent on the best move, the clearer it is that it is the best move. The soft limit
+// is scaled by NodeFractionBase minus the fraction.
+constexpr double NodeFractionBase = 1.6;
+
+constexpr double MinSoftLimitScale = 0.3;
+constexpr double MaxSoftLimitScale = 3.0;
+
+// The effective branching factor that is used to predict the time of the next iteration, if the previous iterations were too
+// short to measure it, and the range it is clamped to otherwise.
+constexpr double DefaultBranchingFactor = 2.0;
+constexpr double MinBranchingFactor = 1.0;
+constexpr double MaxBranchingFactor = 6.0;
+constexpr std::chrono::milliseconds MinMeasurableIterationTime(5);
+
+[[nodiscard]] INLINE std::chrono::milliseconds scaleDuration(std::chrono::milliseconds duration, double scale) {
+    return std::chrono::milliseconds(static_cast<int64_t>(static_cast<double>(duration.count()) * scale));
+}
+
+} // namespace
+
+
+
+TimeManager::TimeManager(std::chrono::milliseconds time, std::chrono::milliseconds increment, std::optional<uint16_t> movesToGo,
+    std::chrono::milliseconds moveOverhead) : start_(std::chrono::steady_clock::now()), softLimit_(), hardLimit_(), bestMove_(Move::invalid()), bestScore_(0),
+                                              stableIterations_(0), primaryElapsed_(0), lastIterationTime_(0),
+                                              previousIterationTime_(0) {
+    // Always leave at least a millisecond to search, even if we are about to lose on time anyway
+    std::chrono::milliseconds available = std::max(time - moveOverhead, std::chrono::milliseconds(1));
+
+    uint16_t moves = movesToGo.has_value() ? std::clamp<uint16_t>(movesToGo.value(), 1, MaxMovesToGo) : DefaultMovesToGo;
+
+    std::chrono::milliseconds base = available / moves + scaleDuration(increment, IncrementUsage);
+
+    this->hardLimit_ = std::min(scaleDuration(base, HardLimitFactor), scaleDuration(available, MaxHardLimitUsage));
+    this->hardLimit_ = std::max(this->hardLimit_, std::chrono::milliseconds(1));
+    this->softLimit_ = std::min(base, this->hardLimit_);
+}
+
+void TimeManager::recordPrimaryIteration() {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - this->start_);
+
+    this->previousIterationTime_ = this->lastIterationTime_;
+    this->lastIterationTime_ = elapsed - this->primaryElapsed_;
+    this->primaryElapsed_ = elapsed;
+}
+
+bool TimeManager::shouldStop(const SearchResult &result) {
+    assert(result.isValid() && !result.isPartial);
+
+    double scale = this->softLimitScale(result);
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - this->start_);
+
+    // Update the state for the next iteration
+    Move bestMove = result.bestLine[0];
+    this->stableIterations_ = (bestMove == this->bestMove_) ? this->stableIterations_ + 1 : 0;
+    this->bestMove_ = bestMove;
+    this->bestScore_ = result.score;
+
+    if (elapsed >= scaleDuration(this->softLimit_, scale)) {
+        return true;
+    }
+
+    // Do not continue with an iteration of the primary thread that will most likely be stopped by the hard limit before it
+    // finishes. Its next iteration started when its last one completed.
+    return this->primaryElapsed_ + this->predictNextIterationTime() > this->hardLimit_;
+}
+
+double TimeManager::softLimitScale(const SearchResult &result) const {
+    bool isFirstIteration = !this->bestMove_.isValid();
+
+    // Best move stability
+    uint16_t stableIterations = (result.bestLine[0] == this->bestMove_) ? this->stableIterations_ + 1 : 0;
+    double stabilityScale = std::max(MaxStabilityScale - StabilityScaleStep * stableIterations, MinStabilityScale);
+
+    // Score drop (mate scores are not comparable to normal scores)
+    double scoreDropScale = 1.0;
+    if (!isFirstIteration && !Score::isMate(result.score) && !Score::isMate(this->bestScore_)) {
+        int32_t drop = std::clamp(this->bestScore_ - result.score, 0, ScoreDropForMaxScale);
+        scoreDropScale += (MaxScoreDropScale - 1.0) * drop / ScoreDropForMaxScale;
+    }
+
+    // Best move node fraction (0 if no nodes were counted, e.g. if there is only one legal move)
+    double nodeFractionScale = (result.bestMoveNodeFraction > 0.0) ? NodeFractionBase - result.bestMoveNodeFraction : 1.0;
+
+    return std::clamp(stabilityScale * scoreDropScale * nodeFractionScale, MinSoftLimitScale, MaxSoftLimitScale);
+}
+
+std::chrono::milliseconds TimeManager::predictNextIterationTime() const {
+    double branchingFactor = DefaultBranchingFactor;
+
+    if (this->previousIterationTime_ >= MinMeasurableIterationTime) {
+        double measured =
+            static_cast<double>(this->lastIterationTime_.count()) / static_cast<double>(this->previousIterationTime_.count());
+        branchingFactor = std::clamp(measured, MinBranchingFactor, MaxBranchingFactor);
+    }
+
+    return scaleDuration(this->lastIterationTime_, branchingFactor);
+}
+
+} // namespace FKTB
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <optional>
+
+#include "engine/inline.h"
+#include "engine/move/move.h"
+
+namespace FKTB {
+
+struct SearchResult;
+
+// Decides how long to search when playing with a clock. There are two limits:
+//  - The hard limit is the most time that the search may ever take. It is enforced by stopping the search, even in the middle of
+//    an iteration.
+//  - The soft limit is the time that we would like to spend on the move. It is only checked between iterations, and is scaled by
+//    how settled the search is, so that less time is spent on easy moves and more time on difficult ones.
+class TimeManager {
+public:
+    // The time and increment are those of the side to move, and movesToGo is the number of moves until the next time control (if
+    // there is one). The move overhead is reserved for every move, to account for communication and other delays.
+    TimeManager(std::chrono::milliseconds time, std::chrono::milliseconds increment, std::optional<uint16_t> movesToGo,
+        std::chrono::milliseconds moveOverhead);
+
+    [[nodiscard]] INLINE std::chrono::milliseconds softLimit() const { return this->softLimit_; }
+    [[nodiscard]] INLINE std::chrono::milliseconds hardLimit() const { return this->hardLimit_; }
+
+    // Must be called whenever the primary search thread completes an iteration, before shouldStop is called with its result. Only
+    // the primary thread's iterations are timed, since the helper threads search other depths, so their iteration times say
+    // nothing about how long the primary thread's next iteration will take.
+    void recordPrimaryIteration();
+
+    // Must be called with every new deepest result, in order. Returns true if the search should stop instead of continuing: either
+    // the scaled soft limit was reached, or the primary thread's next iteration is predicted to not finish before the hard limit.
+    // Time is counted from the construction of the time manager rather than from the start of the search, so that a ponder search
+    // can be handed a time manager on a ponder hit.
+    [[nodiscard]] bool shouldStop(const SearchResult &result);
+
+private:
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::milliseconds softLimit_;
+    std::chrono::milliseconds hardLimit_;
+
+    // The best move and score of the previous iteration, and for how many iterations in a row the best move has not changed.
+    Move bestMove_;
+    int32_t bestScore_;
+    uint16_t stableIterations_;
+
+    // The total time elapsed after the primary thread's last completed iteration, and how long its last two iterations took by
+    // themselves.
+    std::chrono::milliseconds primaryElapsed_;
+    std::chrono::milliseconds lastIterationTime_;
+    std::chrono::milliseconds previousIterationTime_;
+
+    // Returns the factor that the soft limit is scaled by after the given iteration.
+    [[nodiscard]] double softLimitScale(const SearchResult &result) const;
+
+    // Returns the predicted time that the primary thread's next iteration will take, based on the effective branching factor of
+    // its last two iterations.
+    [[nodiscard]] std::chrono::milliseconds predictNextIterationTime() const;
+};
+
+} // namespace FKTB
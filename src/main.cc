@@ -1,22 +1,21 @@
-#include <iostream>
+#include <string>
 
-#include "engine/init.h"
+#include "dispatch.h"
 
-#include "test.h"
-#include "uci.h"
-
-[[noreturn]] void uci() {
-    std::string name = "FKTB 0.0.77";
+void uci() {
+    std::string name = "FKTB 0.0.77 ";
+    name += FKTB::variantName();
 #ifndef NDEBUG
     name += " Debug";
 #endif // #ifndef NDEBUG
-    FKTB::UCIHandler uci(name, "frogscats");
 
-    uci.run();
+    FKTB::uci(name, "frogscats");
 }
 
 int main() {
     FKTB::init();
 
     uci();
+
+    return 0;
 }
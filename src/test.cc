@@ -4,19 +4,24 @@
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <vector>
 #include <stdexcept>
 #include <sstream>
 #include <thread>
 #include <chrono>
 #include <cassert>
+#include <random>
+#include <array>
 
 #include "engine/board/piece.h"
+#include "engine/board/bitboard.h"
 #include "engine/move/movegen.h"
 #include "engine/move/move_list.h"
 #include "engine/eval/evaluation.h"
 #include "engine/hash/transposition.h"
 #include "engine/search/fixed_search.h"
 #include "engine/search/iterative_search.h"
+#include "engine/search/move_ordering/see.h"
 
 namespace FKTB {
 
@@ -48,6 +53,22 @@ std::string formatWithExact(uint64_t number) {
     }
 }
 
+// Positions from openings, middlegames and endgames, used by the depth benchmark.
+constexpr std::array<const char *, 12> BenchmarkFens = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r1bq1rk1/pp2ppbp/2np1np1/8/3NP3/2N1BP2/PPPQ2PP/R3KB1R w KQ - 3 9",
+    "r2q1rk1/pp1bbppp/2n1pn2/3p4/2PP4/2N1PN2/PP1BBPPP/R2QK2R w KQ - 0 10",
+    "8/pp3k2/2p1p1p1/3pP1P1/3P1K2/2P5/PP6/8 w - - 0 40",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "rnbqkb1r/pp1p1ppp/4pn2/2p5/2PP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 0 4",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "2r3k1/pp3ppp/2n1b3/3p4/3P4/2PB1N2/P4PPP/R5K1 b - - 0 20",
+    "r1b2rk1/2q1b1pp/p2ppn2/1p6/3QP3/1BN1B3/PPP3PP/R4RK1 w - - 0 14",
+    "6k1/5p2/6p1/8/7p/8/6PP/6K1 b - - 0 50",
+    "3r1rk1/p4ppp/1pq1pn2/2p5/2P5/1P2P1P1/PB1Q1P1P/3R1RK1 w - - 0 18"
+};
+
 } // namespace
 
 
@@ -100,8 +121,8 @@ void Tests::moveOrderingTest(const std::string &fen, const std::vector<std::stri
     TranspositionTable table(2097152);
     HeuristicTables heuristics;
     SearchStatistics stats;
-    FixedDepthSearcher searcher(board, 9, table, heuristics, stats);
-    static_cast<void>(searcher.search());
+    FixedDepthSearcher searcher(board, table, heuristics, stats);
+    static_cast<void>(searcher.search(9));
 
     // Make the moves
     for (const std::string &moveStr : movesSequence) {
@@ -111,10 +132,11 @@ void Tests::moveOrderingTest(const std::string &fen, const std::vector<std::stri
 
     RootMoveList movesList = MoveGeneration::generateLegalRoot(board);
 
-    MoveOrdering::score<MoveOrdering::Type::All>(movesList, board, &heuristics.history);
+    HistoryContext history(heuristics);
+    MoveOrdering::score<MoveOrdering::Type::All>(movesList, board, &history);
     movesList.sort();
 
-    const std::vector<MoveEntry> &moves = movesList.moves();
+    const std::vector<RootMoveEntry> &moves = movesList.moves();
 
     // Iterate in reverse order, since the moves are sorted from smallest to largest (this was done to optimize dequeueing)
     for (auto it = moves.rbegin(); it != moves.rend(); it++) {
@@ -170,13 +192,16 @@ std::chrono::milliseconds Tests::fixedDepthTest(const std::string &fen, uint16_t
     TranspositionTable table(2097152);
     HeuristicTables heuristics;
     SearchStatistics stats;
-    FixedDepthSearcher searcher(board, depth, table, heuristics, stats);
-    SearchLine bestLine = searcher.search();
+    FixedDepthSearcher searcher(board, table, heuristics, stats);
+    SearchLine bestLine = searcher.search(depth);
 
     std::cout << "Best move: " << bestLine.moves[0].debugName(board) << std::endl;
     std::cout << "Score: " << bestLine.score << std::endl;
     std::cout << "Nodes: " << formatWithExact(stats.nodeCount()) << std::endl;
     std::cout << "Transposition hits: " << formatWithExact(stats.transpositionHits()) << std::endl;
+    std::cout << "Quiescence nodes: " << formatWithExact(stats.quiescenceNodeCount()) << std::endl;
+    std::cout << "Quiescence SEE prunes: " << formatWithExact(stats.quiescenceSeePrunes()) << std::endl;
+    std::cout << "Quiescence delta prunes: " << formatWithExact(stats.quiescenceDeltaPrunes()) << std::endl;
     std::cout << "Time: " << stats.elapsed().count() << "ms" << std::endl;
 
     return stats.elapsed();
@@ -184,6 +209,44 @@ std::chrono::milliseconds Tests::fixedDepthTest(const std::string &fen, uint16_t
 
 
 
+// Depth benchmark
+void Tests::depthBenchmark(uint16_t depth) {
+    std::vector<uint64_t> nodeCounts(depth + 1, 0);
+    std::chrono::milliseconds totalTime(0);
+
+    for (const char *fen : BenchmarkFens) {
+        Board board = Board::fromFen(fen);
+
+        TranspositionTable table(2097152);
+        HeuristicTables heuristics;
+        SearchStatistics stats;
+        FixedDepthSearcher searcher(board, table, heuristics, stats);
+
+        // Order the root moves the same way as the iterative searcher does
+        RootMoveList rootMoves = MoveGeneration::generateLegalRoot(board);
+        MoveOrdering::score<MoveOrdering::Type::AllNoHistory>(rootMoves, board, nullptr);
+        rootMoves.sort();
+
+        // The statistics are not reset between iterations, so the node count is the total needed to complete each depth.
+        for (uint16_t iterationDepth = 1; iterationDepth <= depth; iterationDepth++) {
+            rootMoves.sortByLastIteration();
+            rootMoves.loadHashMove(board, table);
+
+            (void) searcher.search(iterationDepth, rootMoves);
+            nodeCounts[iterationDepth] += stats.nodeCount();
+        }
+
+        totalTime += stats.elapsed();
+    }
+
+    for (uint16_t iterationDepth = 1; iterationDepth <= depth; iterationDepth++) {
+        std::cout << "Depth " << iterationDepth << ": " << formatWithExact(nodeCounts[iterationDepth]) << " nodes" << std::endl;
+    }
+    std::cout << "Time: " << totalTime.count() << "ms" << std::endl;
+}
+
+
+
 // Iterative deepening search test
 void Tests::iterativeTest(const std::string &fen, uint16_t depth, uint32_t threads) {
     assert(threads == 1);
@@ -194,27 +257,206 @@ void Tests::iterativeTest(const std::string &fen, uint16_t depth, uint32_t threa
 
     volatile bool isComplete = false;
 
-    searcher.addIterationCallback([&board, &searcher, &isComplete, depth](const SearchResult &result) {
+    searcher.addIterationCallback([&board](const SearchResult &result) {
         std::cout << result.bestLine[0].debugName(board);
         std::cout << " depth " << result.depth;
         std::cout << " score " << result.score;
         std::cout << " nodes " << formatNumber(result.nodeCount);
         std::cout << " time " << result.elapsed.count() << "ms";
         std::cout << std::endl;
-
-        if (result.depth == depth) {
-            isComplete = true;
-
-            searcher.stop();
-        }
+    });
+    searcher.addFinishCallback([&isComplete]() {
+        isComplete = true;
     });
 
-    searcher.start(board);
+    SearchLimits limits;
+    limits.depth = depth;
+    searcher.start(board, std::move(limits));
 
     // Sleep until the search is complete
     while (!isComplete) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
+
+    (void) searcher.stop();
+}
+
+
+
+// Batch evaluation test
+template<Color Side>
+void collectPositions(Board &board, uint16_t depth, std::vector<Board> &positions) {
+    positions.push_back(board.copy());
+
+    if (depth == 0) {
+        return;
+    }
+
+    AlignedMoveEntry moveBuffer[MaxMoveCount];
+    MoveEntry *movesStart = MoveEntry::fromAligned(moveBuffer);
+
+    MoveEntry *movesEnd = MoveGeneration::generate<Side, MoveGeneration::Type::Legal>(board, movesStart);
+
+    for (MoveEntry *entry = movesStart; entry != movesEnd; entry++) {
+        MakeMoveInfo info = board.makeMove<MakeMoveType::All>(entry->move);
+
+        collectPositions<~Side>(board, depth - 1, positions);
+
+        board.unmakeMove<MakeMoveType::All>(entry->move, info);
+    }
+}
+
+void Tests::batchEvaluationTest(const std::string &fen, uint16_t depth, uint32_t threads) {
+    Board board = Board::fromFen(fen);
+
+    std::vector<Board> positions;
+    if (board.turn() == Color::White) {
+        collectPositions<Color::White>(board, depth, positions);
+    } else {
+        collectPositions<Color::Black>(board, depth, positions);
+    }
+
+    std::vector<int32_t> expected(positions.size());
+    std::vector<int32_t> actual(positions.size());
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < positions.size(); i++) {
+        const Board &position = positions[i];
+        if (position.turn() == Color::White) {
+            expected[i] = Evaluation::evaluate<Color::White>(position, -INT32_MAX, INT32_MAX);
+        } else {
+            expected[i] = Evaluation::evaluate<Color::Black>(position, -INT32_MAX, INT32_MAX);
+        }
+    }
+
+    auto middle = std::chrono::steady_clock::now();
+
+    Evaluation::evaluateBatch(positions.data(), positions.size(), actual.data(), threads);
+
+    auto end = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < positions.size(); i++) {
+        if (expected[i] != actual[i]) {
+            throw std::runtime_error("Batch evaluation does not match. Fen: " + positions[i].toFen());
+        }
+    }
+
+    auto singleDuration = std::chrono::duration_cast<std::chrono::microseconds>(middle - start).count();
+    auto batchDuration = std::chrono::duration_cast<std::chrono::microseconds>(end - middle).count();
+
+    std::cout << "Batch evaluation test passed" << std::endl;
+    std::cout << "Positions: " << formatWithExact(positions.size()) << std::endl;
+    std::cout << "One at a time: " << singleDuration << "us" << std::endl;
+    std::cout << "Batched: " << batchDuration << "us" << std::endl;
+}
+
+
+
+// Slider attack benchmark
+template<Bitboard (*Attacks)(Square, Bitboard)>
+Bitboard lookupAllAttacks(Bitboard sliders, Bitboard occupied) {
+    Bitboard attacks;
+    for (Square slider : sliders) {
+        attacks |= Attacks(slider, occupied);
+    }
+    return attacks;
+}
+
+// Compares the PEXT and magic lookups of one slider type for every subset of the squares it attacks on an empty board, from every
+// square. The subsets are enumerated with the Carry-Rippler trick, and include the squares on the edge of the board, which the
+// lookups must ignore.
+template<Bitboard (*PextAttacks)(Square, Bitboard), Bitboard (*MagicAttacks)(Square, Bitboard)>
+void verifySliderBackends(const char *name, Bitboard (*attacksOnEmpty)(Square)) {
+    for (uint8_t square = 0; square < 64; ++square) {
+        Bitboard mask = attacksOnEmpty(square);
+
+        Bitboard occupied = 0;
+        do {
+            if (PextAttacks(square, occupied) != MagicAttacks(square, occupied)) {
+                throw std::runtime_error(std::string("Slider attack backends disagree for a ") + name + " on square "
+                    + Square(square).debugName() + ".");
+            }
+
+            occupied = (occupied - mask) & mask;
+        } while (occupied != 0);
+    }
+}
+
+// Attacks is either a single slider lookup (taking a Square) or an attack map of a set of sliders (taking a Bitboard).
+template<auto Attacks, typename T>
+std::pair<uint64_t, uint64_t> benchmarkSliderAttacks(const std::vector<T> &sliders, const std::vector<Bitboard> &occupancies,
+                                                     uint32_t iterations) {
+    uint64_t result = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t iteration = 0; iteration < iterations; iteration++) {
+        for (size_t i = 0; i < sliders.size(); i++) {
+            result += Attacks(sliders[i], occupancies[i]);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return { result, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() };
+}
+
+template<auto Attacks, typename T>
+void printSliderAttackBenchmark(const char *name, const std::vector<T> &sliders, const std::vector<Bitboard> &occupancies,
+                                uint32_t iterations) {
+    auto [result, nanoseconds] = benchmarkSliderAttacks<Attacks>(sliders, occupancies, iterations);
+    double lookups = static_cast<double>(sliders.size()) * iterations;
+
+    // Print the result so that the compiler cannot optimize away the lookups.
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(2)
+              << (static_cast<double>(nanoseconds) / lookups) << " ns/lookup (checksum " << std::hex << result
+              << std::dec << ")" << std::endl;
+}
+
+void Tests::sliderAttackBenchmark() {
+    constexpr size_t LookupCount = 1 << 16;
+    constexpr uint32_t Iterations = 256;
+
+    // Random squares and occupancies, with roughly the density of a middlegame position.
+    std::mt19937_64 random(0);
+    std::vector<Square> squares(LookupCount);
+    std::vector<Bitboard> occupancies(LookupCount);
+    for (size_t i = 0; i < LookupCount; i++) {
+        squares[i] = static_cast<uint8_t>(random() % 64);
+        occupancies[i] = random() & random();
+    }
+
+    // A bad magic number only gives wrong attacks for some occupancies, so every one of them is checked.
+    verifySliderBackends<Bitboards::Pext::bishopAttacks, Bitboards::Magic::bishopAttacks>("bishop",
+        Bitboards::bishopAttacksOnEmpty);
+    verifySliderBackends<Bitboards::Pext::rookAttacks, Bitboards::Magic::rookAttacks>("rook", Bitboards::rookAttacksOnEmpty);
+
+    // Random sets of up to three sliders, which may overlap with the occupancies.
+    std::vector<Bitboard> sliders(LookupCount);
+    for (size_t i = 0; i < LookupCount; i++) {
+        for (uint32_t j = random() % 4; j > 0; j--) {
+            sliders[i].set(random() % 64);
+        }
+    }
+
+    for (size_t i = 0; i < LookupCount; i++) {
+        if (Bitboards::allBishopAttacks(sliders[i], occupancies[i]) != lookupAllAttacks<Bitboards::bishopAttacks>(sliders[i],
+            occupancies[i]) || Bitboards::allRookAttacks(sliders[i], occupancies[i]) !=
+            lookupAllAttacks<Bitboards::rookAttacks>(sliders[i], occupancies[i])) {
+            throw std::runtime_error("Slider attack maps disagree with the slider attack lookups.");
+        }
+    }
+
+    std::cout << "Selected backend: " << (Bitboards::SelectedSliderBackend == Bitboards::SliderBackend::Pext ? "PEXT" : "Magic")
+              << std::endl;
+    printSliderAttackBenchmark<Bitboards::Pext::bishopAttacks>("PEXT bishop", squares, occupancies, Iterations);
+    printSliderAttackBenchmark<Bitboards::Magic::bishopAttacks>("Magic bishop", squares, occupancies, Iterations);
+    printSliderAttackBenchmark<Bitboards::Pext::rookAttacks>("PEXT rook", squares, occupancies, Iterations);
+    printSliderAttackBenchmark<Bitboards::Magic::rookAttacks>("Magic rook", squares, occupancies, Iterations);
+
+    printSliderAttackBenchmark<lookupAllAttacks<Bitboards::bishopAttacks>>("Lookup bishops", sliders, occupancies, Iterations);
+    printSliderAttackBenchmark<Bitboards::allBishopAttacks>("Map bishops", sliders, occupancies, Iterations);
+    printSliderAttackBenchmark<lookupAllAttacks<Bitboards::rookAttacks>>("Lookup rooks", sliders, occupancies, Iterations);
+    printSliderAttackBenchmark<Bitboards::allRookAttacks>("Map rooks", sliders, occupancies, Iterations);
 }
 
 
@@ -323,6 +565,59 @@ void Tests::hashTest(const std::string &fen, uint16_t depth) {
 
 
 
+// Threshold SEE test
+template<Color Side>
+uint64_t seeTestSearch(Board &board, uint16_t depth) {
+    AlignedMoveEntry moveBuffer[MaxMoveCount];
+    MoveEntry *movesStart = MoveEntry::fromAligned(moveBuffer);
+
+    MoveEntry *movesEnd = MoveGeneration::generate<Side, MoveGeneration::Type::Legal>(board, movesStart);
+
+    uint64_t moveCount = 0;
+
+    for (MoveEntry *entry = movesStart; entry != movesEnd; entry++) {
+        Move move = entry->move;
+
+        // The full evaluation does not count the material gained by promoting, and does not handle castling.
+        if (!move.isPromotion() && !move.isCastle()) {
+            int32_t score = See::evaluate<Side>(move, board);
+
+            for (int32_t threshold : { -PieceMaterial::Knight, -1, 0, 1, PieceMaterial::Pawn, PieceMaterial::Rook }) {
+                if (See::isAtLeast<Side>(move, board, threshold) != (score >= threshold)) {
+                    throw std::runtime_error("Threshold SEE does not match SEE for move " + move.uci() + " and threshold "
+                        + std::to_string(threshold) + ". Fen: " + board.toFen());
+                }
+            }
+
+            moveCount++;
+        }
+
+        if (depth > 1) {
+            MakeMoveInfo info = board.makeMove<MakeMoveType::All>(move);
+            moveCount += seeTestSearch<~Side>(board, depth - 1);
+            board.unmakeMove<MakeMoveType::All>(move, info);
+        }
+    }
+
+    return moveCount;
+}
+
+void Tests::seeTest(const std::string &fen, uint16_t depth) {
+    Board board = Board::fromFen(fen);
+
+    uint64_t moveCount;
+    if (board.turn() == Color::White) {
+        moveCount = seeTestSearch<Color::White>(board, depth);
+    } else {
+        moveCount = seeTestSearch<Color::Black>(board, depth);
+    }
+
+    std::cout << "SEE test passed successfully." << std::endl;
+    std::cout << "Moves: " << formatWithExact(moveCount) << std::endl;
+}
+
+
+
 // Perft test
 template<Color Side>
 uint64_t perftSearch(Board &board, uint16_t depth) {
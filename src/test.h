@@ -26,15 +26,31 @@ void benchmark();
 // Runs a fixed depth search on a given position.
 std::chrono::milliseconds fixedDepthTest(const std::string &fen, uint16_t depth);
 
+// Searches each benchmark position with iterative deepening up to the given depth, and prints the total number of nodes that were
+// needed to complete each depth. Unlike the fixed depth search, this includes the effect of hash moves from previous iterations.
+void depthBenchmark(uint16_t depth);
+
 // Runs an iterative deepening search on a given position.
 void iterativeTest(const std::string &fen, uint16_t depth, uint32_t threads);
 
+// Verifies that batched evaluation gives the same results as evaluating every position reachable from the given position within
+// the given depth one at a time, and compares their speeds.
+void batchEvaluationTest(const std::string &fen, uint16_t depth, uint32_t threads);
+
+// Compares the speed of the PEXT and magic slider attack backends, and verifies that they agree for every occupancy. Also verifies that the slider
+// attack maps agree with looking up the attacks of each slider, and compares their speeds.
+void sliderAttackBenchmark();
+
 // Verifies that unmakeMove is working correctly.
 void unmakeMoveTest(const std::string &fen);
 
 // Verifies that the Zobrist hash is working correctly.
 void hashTest(const std::string &fen, uint16_t depth);
 
+// Verifies that threshold static exchange evaluation agrees with the full static exchange evaluation on whether each move loses
+// material, for every move reachable from the given position within the given depth.
+void seeTest(const std::string &fen, uint16_t depth);
+
 // Performs a perft test on a given position.
 void perft(const std::string &fen, uint16_t depth);
 
@@ -15,9 +15,22 @@
 #include "engine/search/score.h"
 #include "engine/move/movegen.h"
 #include "engine/search/iterative_search.h"
+#include "engine/search/time_manager.h"
 
 namespace FKTB::UCI {
 
+namespace {
+
+constexpr uint32_t DefaultThreads = 1;
+constexpr uint32_t MaxThreads = 256;
+
+constexpr std::chrono::milliseconds DefaultMoveOverhead(10);
+constexpr std::chrono::milliseconds MaxMoveOverhead(5000);
+
+} // namespace
+
+
+
 TokenStream::TokenStream(const std::string &input) : index_(0), tokens_() {
     std::stringstream ss(input);
     std::string item;
@@ -59,120 +72,35 @@ std::string TokenStream::readUntil(const std::string &token) {
 
 
 
-// Search stopping needs to be asynchronous from a separate thread so that the main thread can continue to process input while we
-// wait for a duration/node count to pass.
-//
-// Note: This thread does not handle limiting the search depth, since that is done in the search iteration callback.
-// TODO: Add a destructor to properly kill the thread.
-class Handler::SearchStopThread {
-public:
-    explicit SearchStopThread(Handler &uci);
-
-    void limitNodes(uint64_t nodeCount);
-    void limitTime(std::chrono::milliseconds duration);
-
-    void enable();
-    void disable();
-
-private:
-    Handler &uci_;
-    std::thread thread_;
-
-    ami::mutex mutex_;
-    bool isEnabled_ = false;
-    std::optional<uint64_t> nodeLimit_ = std::nullopt;
-    std::optional<std::chrono::time_point<std::chrono::steady_clock>> timeLimit_ = std::nullopt;
-
-    [[noreturn]] void loop();
-};
-
-Handler::SearchStopThread::SearchStopThread(Handler &uci) : uci_(uci) {
-    this->thread_ = std::thread(&SearchStopThread::loop, this);
-    this->thread_.detach();
-}
-
-void Handler::SearchStopThread::limitNodes(uint64_t nodeCount) {
-    assert(!this->mutex_.locked_by_caller() && "SearchStopThread::limitNodes() must not be called with the mutex locked.");
-    std::lock_guard lock(this->mutex_);
-
-    // If there is already a node limit, choose whichever is smaller, since that one will always stop the search first.
-    if (!this->nodeLimit_.has_value() || nodeCount < this->nodeLimit_.value()) {
-        this->nodeLimit_ = nodeCount;
-    }
-}
-
-void Handler::SearchStopThread::limitTime(std::chrono::milliseconds duration) {
-    assert(!this->mutex_.locked_by_caller() && "SearchStopThread::limitTime() must not be called with the mutex locked.");
-    std::lock_guard lock(this->mutex_);
-
-    // If there is already a time limit, choose whichever is sooner, since that one will always stop the search first.
-    auto timeLimit = std::chrono::steady_clock::now() + duration;
-    if (!this->timeLimit_.has_value() || timeLimit < this->timeLimit_.value()) {
-        this->timeLimit_ = timeLimit;
-    }
-}
-
-void Handler::SearchStopThread::enable() {
-    assert(!this->mutex_.locked_by_caller() && "SearchStopThread::enable() must not be called with the mutex locked.");
-    std::lock_guard lock(this->mutex_);
-    this->isEnabled_ = true;
-}
-
-void Handler::SearchStopThread::disable() {
-    assert(!this->mutex_.locked_by_caller() && "SearchStopThread::disable() must not be called with the mutex locked.");
-    std::lock_guard lock(this->mutex_);
-    this->isEnabled_ = false;
-    this->nodeLimit_ = std::nullopt;
-    this->timeLimit_ = std::nullopt;
-}
-
-[[noreturn]] void Handler::SearchStopThread::loop() {
-    while (true) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
-
-        bool shouldStop = false;
-        {
-            std::lock_guard lock(this->mutex_);
-
-            if (!this->isEnabled_) {
-                continue;
-            }
-
-            // Node limit
-            shouldStop |= (this->nodeLimit_.has_value() && this->uci_.searcher_->stats().nodeCount() >= this->nodeLimit_.value());
-
-            // Time limit
-            shouldStop |= (this->timeLimit_.has_value() && std::chrono::steady_clock::now() >= this->timeLimit_.value());
-        }
-
-        // Stop the search if necessary.
-        if (shouldStop) {
-            this->uci_.lockAndMaybeStopSearch();
-        }
-    }
-}
-
-
-
 Handler::Handler(std::string name, std::string author) : name_(std::move(name)), author_(std::move(author)),
-                                                         board_(nullptr) {
-//    this->searcher_ = std::make_unique<IterativeSearcher>(std::thread::hardware_concurrency());
-    this->searcher_ = std::make_unique<IterativeSearcher>(1);
+                                                         moveOverhead_(DefaultMoveOverhead), board_(nullptr) {
+    this->searcher_ = std::make_unique<IterativeSearcher>(DefaultThreads);
     this->searcher_->addIterationCallback([this](const SearchResult &result) {
         this->iterationCallback(result);
     });
-
-    this->searchStopThread_ = std::make_unique<SearchStopThread>(*this);
+    this->searcher_->addFinishCallback([this]() {
+        this->finishCallback();
+    });
 }
 
-Handler::~Handler() = default;
+Handler::~Handler() {
+    {
+        std::lock_guard lock(this->mutex_);
+        this->cancelSearch();
+    }
+
+    // The search threads are joined when the searcher is destroyed. It is declared last, so it is destroyed before anything that
+    // a late callback from a search thread could still use.
+    this->searcher_ = nullptr;
+}
 
-[[noreturn]] void Handler::run() {
-    while (true) {
+void Handler::run() {
+    while (!this->isQuitting_) {
         try {
-            std::string input = this->readInput();
+            // The end of the input (e.g. the GUI closed the pipe) is treated like the quit command
+            std::optional<std::string> input = this->readInput();
 
-            this->handleInput(input);
+            this->handleInput(input.value_or("quit"));
         } catch (const std::exception &e) {
             this->error(std::string("Uncaught exception: ") + e.what());
         }
@@ -189,9 +117,12 @@ void Handler::error(const std::string &message) {
     this->maybeLog("[err] " + message);
 }
 
-std::string Handler::readInput() {
+std::optional<std::string> Handler::readInput() {
     std::string input;
-    std::getline(std::cin, input);
+    if (!std::getline(std::cin, input)) {
+        return std::nullopt;
+    }
+
     this->maybeLog("[in] " + input);
     return input;
 }
@@ -229,6 +160,8 @@ void Handler::handleInput(const std::string &input) {
         this->handleGo(tokens);
     } else if (command == "stop") {
         this->handleStop(tokens);
+    } else if (command == "ponderhit") {
+        this->handlePonderHit(tokens);
     } else if (command == "quit") {
         this->handleQuit(tokens);
     } else if (command == "test") {
@@ -248,12 +181,29 @@ void Handler::handleUci(TokenStream &tokens) {
     this->send("id name " + this->name_);
     this->send("id author " + this->author_);
     this->send("option name Log File type string default");
+    this->send("option name Ponder type check default false");
+    this->send("option name Threads type spin default " + std::to_string(DefaultThreads) + " min 1 max "
+        + std::to_string(MaxThreads));
+    this->send("option name Move Overhead type spin default " + std::to_string(DefaultMoveOverhead.count()) + " min 0 max "
+        + std::to_string(MaxMoveOverhead.count()));
     this->send("uciok");
 }
 
 void Handler::handleDebug(TokenStream &tokens) {
     assert(this->mutex_.locked_by_caller() && "Handler::handleDebug() must be called with the mutex locked.");
-    return this->error("Debug mode does not do anything");
+
+    if (tokens.isEnd()) {
+        return this->error("debug command requires 'on' or 'off' as argument");
+    }
+
+    const std::string &mode = tokens.next();
+    if (mode == "on") {
+        this->isDebugging_ = true;
+    } else if (mode == "off") {
+        this->isDebugging_ = false;
+    } else {
+        return this->error("debug command requires 'on' or 'off' as argument");
+    }
 }
 
 void Handler::handleIsReady(TokenStream &tokens) {
@@ -292,6 +242,12 @@ void Handler::handleSetOption(TokenStream &tokens) {
     // Handle option
     if (name == "Log File") {
         this->handleSetLogFile(value);
+    } else if (name == "Move Overhead") {
+        this->handleSetMoveOverhead(value);
+    } else if (name == "Threads") {
+        this->handleSetThreads(value);
+    } else if (name == "Ponder") {
+        // Nothing to do, the GUI decides when to ponder with go ponder. The option only tells the GUI that pondering is supported.
     } else {
         return this->error("Unknown option: " + name);
     }
@@ -353,6 +309,8 @@ void Handler::handleGo(TokenStream &tokens) {
 
         if (command == "infinite") {
             options.infinite = true;
+        } else if (command == "ponder") {
+            options.ponder = true;
         } else if (command == "wtime") {
             if (tokens.isEnd()) return this->error("wtime command requires an argument");
             options.timeControl.time.white() = std::stoi(tokens.next());
@@ -365,6 +323,9 @@ void Handler::handleGo(TokenStream &tokens) {
         } else if (command == "binc") {
             if (tokens.isEnd()) return this->error("binc command requires an argument");
             options.timeControl.increment.black() = std::stoi(tokens.next());
+        } else if (command == "movestogo") {
+            if (tokens.isEnd()) return this->error("movestogo command requires an argument");
+            options.timeControl.movesToGo = std::stoi(tokens.next());
         } else if (command == "depth") {
             if (tokens.isEnd()) return this->error("depth command requires an argument");
             options.depth = std::stoi(tokens.next());
@@ -392,6 +353,27 @@ void Handler::handleStop(TokenStream &tokens) {
     this->stopSearch();
 }
 
+void Handler::handlePonderHit(TokenStream &tokens) {
+    assert(this->mutex_.locked_by_caller() && "Handler::handlePonderHit() must be called with the mutex locked.");
+
+    if (!tokens.isEnd()) {
+        return this->error("ponderhit command does not take arguments");
+    }
+
+    if (!this->isSearching_ || !this->isPondering_) {
+        return this->error("Not pondering");
+    }
+
+    // The opponent played the expected move, so keep searching, but with the clock running now
+    this->isPondering_ = false;
+    this->searcher_->setLimits(this->searchLimits(this->searchOptions_.value()));
+
+    // If the search already finished while pondering, its finish callback was ignored, so the best move has to be sent now
+    if (this->searcher_->isFinished() && !this->searchOptions_->infinite) {
+        this->stopSearch();
+    }
+}
+
 void Handler::handleQuit(TokenStream &tokens) {
     assert(this->mutex_.locked_by_caller() && "Handler::handleQuit() must be called with the mutex locked.");
 
@@ -399,7 +381,8 @@ void Handler::handleQuit(TokenStream &tokens) {
         return this->error("quit command does not take arguments");
     }
 
-    std::exit(0);
+    this->cancelSearch();
+    this->isQuitting_ = true;
 }
 
 
@@ -416,6 +399,44 @@ void Handler::handleSetLogFile(const std::string &path) {
     this->send("info string Log file set to: " + path);
 }
 
+void Handler::handleSetThreads(const std::string &value) {
+    assert(this->mutex_.locked_by_caller() && "Handler::handleSetThreads() must be called with the mutex locked.");
+
+    if (this->isSearching_) {
+        return this->error("Cannot change the number of threads while searching");
+    }
+
+    int32_t threads;
+    try {
+        threads = std::stoi(value);
+    } catch (const std::exception &) {
+        return this->error("Invalid number of threads: " + value);
+    }
+
+    if (threads < 1 || threads > static_cast<int32_t>(MaxThreads)) {
+        return this->error("Number of threads out of range: " + value);
+    }
+
+    this->searcher_->setThreadCount(threads);
+}
+
+void Handler::handleSetMoveOverhead(const std::string &value) {
+    assert(this->mutex_.locked_by_caller() && "Handler::handleSetMoveOverhead() must be called with the mutex locked.");
+
+    int32_t overhead;
+    try {
+        overhead = std::stoi(value);
+    } catch (const std::exception &) {
+        return this->error("Invalid move overhead: " + value);
+    }
+
+    if (overhead < 0 || overhead > MaxMoveOverhead.count()) {
+        return this->error("Move overhead out of range: " + value);
+    }
+
+    this->moveOverhead_ = std::chrono::milliseconds(overhead);
+}
+
 
 
 void Handler::handleTest(TokenStream &tokens) {
@@ -466,36 +487,33 @@ void Handler::startSearch(const SearchOptions &options) {
     }
 
     this->isSearching_ = true;
+    this->isPondering_ = options.ponder;
     this->searchOptions_ = options;
 
-    this->searcher_->start(*this->board_);
-
-    Color us = this->board_->turn();
-
-    // Time control
-    if (options.timeControl.time[us].has_value()) {
-        int32_t time = options.timeControl.time[us].value();
+    // When pondering, the limits are only applied on a ponder hit
+    this->searcher_->start(*this->board_, options.ponder ? SearchLimits() : this->searchLimits(options));
+}
 
-        // Assume we have 40 moves left
-        int32_t movesLeft = 40;
+SearchLimits Handler::searchLimits(const SearchOptions &options) const {
+    SearchLimits limits;
+    limits.depth = options.depth;
+    limits.nodes = options.nodes;
 
-        int32_t timeLimit = time / movesLeft;
-        this->searchStopThread_->limitTime(std::chrono::milliseconds(timeLimit));
+    // Move time limit
+    if (options.moveTime.has_value()) {
+        limits.time = std::chrono::milliseconds(options.moveTime.value());
     }
 
-    // Node limit
-    if (options.nodes.has_value()) {
-        this->searchStopThread_->limitNodes(options.nodes.value());
-    }
+    // Time control
+    Color us = this->board_->turn();
+    if (options.timeControl.time[us].has_value()) {
+        std::chrono::milliseconds time(options.timeControl.time[us].value());
+        std::chrono::milliseconds increment(options.timeControl.increment[us].value_or(0));
 
-    // Move time limit
-    if (options.moveTime.has_value()) {
-        int32_t moveTime = options.moveTime.value();
-        this->searchStopThread_->limitTime(std::chrono::milliseconds(moveTime));
+        limits.timeManager.emplace(time, increment, options.timeControl.movesToGo, this->moveOverhead_);
     }
 
-    // Enable search stop thread
-    this->searchStopThread_->enable();
+    return limits;
 }
 
 void Handler::stopSearch() {
@@ -505,9 +523,6 @@ void Handler::stopSearch() {
         return this->error("Not searching");
     }
 
-    // Disable any search stop thread limits
-    this->searchStopThread_->disable();
-
     // Stop the search
     SearchResult result = this->searcher_->stop();
 
@@ -524,37 +539,64 @@ void Handler::stopSearch() {
         result.bestLine = { moves.dequeue() };
     }
 
-    this->send("bestmove " + result.bestLine[0].uci());
+    // The iteration callbacks are only called for complete iterations, so report the partial iteration that the best move came
+    // from here
+    if (result.isPartial) {
+        this->sendSearchInfo(result);
+    }
+
+    if (this->isDebugging_) {
+        this->send("info string stop latency " + std::to_string(result.stopLatency.count()) + "us");
+    }
+
+    // The second move of the principal variation is the reply that we expect, so the GUI can ponder on it
+    std::string message = "bestmove " + result.bestLine[0].uci();
+    if (result.bestLine.size() >= 2) {
+        message += " ponder " + result.bestLine[1].uci();
+    }
+    this->send(message);
 
     // Search state needs to be reset last, in case any iteration callbacks are called between the time stopSearch() is called
     // and now.
     this->isSearching_ = false;
+    this->isPondering_ = false;
     this->searchOptions_ = std::nullopt;
 }
 
-// Locks the mutex and stops the search. This should be used when the search is being stopped from a different thread. This
-// function also checks if another thread stopped the search between the time that this function was called and the time that
-// the mutex was acquired. If the search was already stopped by another thread, this function does nothing.
-void Handler::lockAndMaybeStopSearch() {
-    assert(!this->mutex_.locked_by_caller() && "Handler::lockAndStopSearch() must not be called with the mutex locked.");
+void Handler::cancelSearch() {
+    assert(this->mutex_.locked_by_caller() && "Handler::cancelSearch() must be called with the mutex locked.");
 
-    std::lock_guard lock(this->mutex_);
-
-    // Check if another thread already stopped the search
     if (!this->isSearching_) {
         return;
     }
 
-    this->stopSearch();
+    (void) this->searcher_->stop();
+
+    this->isSearching_ = false;
+    this->isPondering_ = false;
+    this->searchOptions_ = std::nullopt;
 }
 
-void Handler::iterationCallback(const SearchResult &result) {
-    assert(!this->mutex_.locked_by_caller() && "Handler::iterationCallback() must not be called with the mutex locked.");
+void Handler::finishCallback() {
+    assert(!this->mutex_.locked_by_caller() && "Handler::finishCallback() must not be called with the mutex locked.");
 
-    if (!this->isSearching_ || !this->searchOptions_.has_value()) {
-        return this->error("Iteration callback somehow called when not searching");
+    std::lock_guard lock(this->mutex_);
+
+    // Check if the search was already stopped (and possibly another search started) before we could lock the mutex
+    if (!this->isSearching_ || !this->searcher_->isFinished()) {
+        return;
+    }
+
+    // In infinite mode, the best move must not be sent before the GUI sends stop. When pondering, it must not be sent before
+    // ponderhit or stop (see handlePonderHit).
+    if (this->searchOptions_->infinite || this->isPondering_) {
+        return;
     }
 
+    this->stopSearch();
+}
+
+void Handler::sendSearchInfo(const SearchResult &result) {
     uint64_t millis = result.elapsed.count();
 
     // Calculate nodes per second
@@ -568,12 +610,18 @@ void Handler::iterationCallback(const SearchResult &result) {
     // Print the search result
     std::string message = "info";
     message += " depth " + std::to_string(result.depth);
+    message += " seldepth " + std::to_string(result.selectiveDepth);
     message += " score ";
     if (Score::isMate(result.score)) {
         message += "mate " + std::to_string(Score::mateMoves(result.score));
     } else {
         message += "cp " + std::to_string(result.score);
     }
+
+    // The root moves that were not searched in a partial iteration could still be better, so its score is only a lower bound
+    if (result.isPartial) {
+        message += " lowerbound";
+    }
     message += " time " + std::to_string(millis);
     message += " nodes " + std::to_string(result.nodeCount);
     message += " nps " + std::to_string(nps);
@@ -586,15 +634,16 @@ void Handler::iterationCallback(const SearchResult &result) {
         }
     }
     this->send(message);
+}
+
+void Handler::iterationCallback(const SearchResult &result) {
+    assert(!this->mutex_.locked_by_caller() && "Handler::iterationCallback() must not be called with the mutex locked.");
 
-    // Depth limit
-    if (this->searchOptions_->depth.has_value() && result.depth >= this->searchOptions_->depth.value()) {
-        // Spawn a new thread to stop the search (cannot stop it from this thread because this thread IS the search
-        // thread, since we are in the search callback). Trying to stop it from this thread would cause a deadlock.
-        std::thread([this]() {
-            this->lockAndMaybeStopSearch();
-        }).detach();
+    if (!this->isSearching_ || !this->searchOptions_.has_value()) {
+        return this->error("Iteration callback somehow called when not searching");
     }
+
+    this->sendSearchInfo(result);
 }
 
 } // namespace FKTB::UCI
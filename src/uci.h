@@ -41,10 +41,12 @@ private:
 struct TimeControl {
     ColorMap<std::optional<int32_t>> time;
     ColorMap<std::optional<int32_t>> increment;
+    std::optional<uint16_t> movesToGo;
 };
 
 struct SearchOptions {
     bool infinite = false;
+    bool ponder = false;
     TimeControl timeControl;
     std::optional<uint16_t> depth;
     std::optional<uint64_t> nodes;
@@ -56,26 +58,36 @@ public:
     Handler(std::string name, std::string author);
     ~Handler();
 
-    [[noreturn]] void run();
+    // Runs the UCI loop until the quit command or the end of the input.
+    void run();
 
 private:
-    class SearchStopThread;
-
     std::string name_, author_;
 
     std::unique_ptr<std::ofstream> logFile_;
 
+    // Time reserved for every move to account for communication delays with the GUI (UCI option "Move Overhead").
+    std::chrono::milliseconds moveOverhead_;
+
     ami::mutex mutex_;
+    bool isQuitting_ = false;
+
+    // In debug mode (UCI command "debug on"), additional information about the search is sent as info strings.
+    bool isDebugging_ = false;
     bool isSearching_ = false;
+
+    // While pondering, the search runs without limits, and the best move must not be sent until the GUI sends ponderhit (which
+    // turns the search into a normal search with the limits from the go command) or stop.
+    bool isPondering_ = false;
     std::optional<SearchOptions> searchOptions_;
-    std::unique_ptr<SearchStopThread> searchStopThread_;
 
     std::unique_ptr<Board> board_;
     std::unique_ptr<IterativeSearcher> searcher_;
 
     void send(const std::string &message);
     void error(const std::string &message);
-    std::string readInput();
+    // Returns std::nullopt at the end of the input.
+    std::optional<std::string> readInput();
 
     // Logs the message if a log file is set.
     void maybeLog(const std::string &message);
@@ -90,9 +102,12 @@ private:
     void handlePosition(TokenStream &tokens);
     void handleGo(TokenStream &tokens);
     void handleStop(TokenStream &tokens);
+    void handlePonderHit(TokenStream &tokens);
     void handleQuit(TokenStream &tokens);
 
     void handleSetLogFile(const std::string &path);
+    void handleSetThreads(const std::string &value);
+    void handleSetMoveOverhead(const std::string &value);
 
     void handleTest(TokenStream &tokens);
     void handleTestMoveGen(TokenStream &tokens);
@@ -100,14 +115,22 @@ private:
 
 
 
+    // Returns the limits of a search with the given options for the current board.
+    [[nodiscard]] SearchLimits searchLimits(const SearchOptions &options) const;
+
     void startSearch(const SearchOptions &options);
     void stopSearch();
+
+    // Stops the search (if there is one) without sending a best move, e.g. when quitting.
+    void cancelSearch();
     void iterationCallback(const SearchResult &result);
 
-    // Locks the mutex and stops the search. This should be used when the search is being stopped from a different thread. This
-    // function also checks if another thread stopped the search between the time that this function was called and the time that
-    // the mutex was acquired. If the search was already stopped by another thread, this function does nothing.
-    void lockAndMaybeStopSearch();
+    // Sends an info line with the depth, score, statistics and principal variation of the search result.
+    void sendSearchInfo(const SearchResult &result);
+
+    // Called from the search thread when the search finished by itself because it reached one of its limits. Locks the mutex and
+    // stops the search, unless it was already stopped, or it is an infinite search (which must wait for the stop command).
+    void finishCallback();
 };
 
 } // namespace UCI
@@ -0,0 +1,15 @@
+#include "variant.h"
+
+#include <string>
+
+#include "uci.h"
+
+namespace FKTB {
+
+void Variant::uci(const std::string &name, const std::string &author) {
+    UCIHandler uci(name, author);
+
+    uci.run();
+}
+
+} // namespace FKTB
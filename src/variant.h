@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+// The entry points of an engine variant. Every variant is compiled with the FKTB namespace renamed for its instruction set (e.g.
+// to FKTB_x86_64_v3), and the dispatcher calls into the variant selected for the CPU through these.
+namespace FKTB::Variant {
+
+// Runs the UCI loop until the GUI quits.
+void uci(const std::string &name, const std::string &author);
+
+} // namespace FKTB::Variant